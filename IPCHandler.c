@@ -36,230 +36,4438 @@
 /*******************************************************************************
  * Includes
  ******************************************************************************/
+#include <stddef.h>
 #include "IPCHandler.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
-#define IPC_HANDLER_CNT_MAX     E_IPC_TASK_ID_LAST
+/**
+* Static topology (see IPC_TOPOLOGY in IPCHandler.h). Every entry is a handler
+* IPC_sTopo_<aTaskID> at index IPC_TOPO_IDX_<aTaskID> of the handler table,
+* which then holds exactly these handlers.
+*/
+#if defined(IPC_TOPOLOGY)
+#undef IPC_HANDLER_CNT_MAX
+#define IPC_HANDLER_CNT_MAX     IPC_TOPO_CNT
+#endif
+#ifndef IPC_HANDLER_CNT_MAX
+#define IPC_HANDLER_CNT_MAX     E_IPC_TASK_ID_LAST      /*!< Number of handlers that can be created */
+#endif
+#define IPC_TASK_ID_CNT         (E_IPC_TASK_ID_LAST + 1)    /*!< Number of entries of the lookup table */
+#ifndef IPC_TOPIC_SUB_MAX
+#define IPC_TOPIC_SUB_MAX       8                       /*!< Number of subscribers a topic can have */
+#endif
+#ifndef IPC_NOTIFY_INDEX
+#define IPC_NOTIFY_INDEX        0                       /*!< Task notification index new handlers use */
+#endif
+#ifndef IPC_CALL_CNT_MAX
+#define IPC_CALL_CNT_MAX        8                       /*!< Number of IPC_call() requests that can wait for a reply at once */
+#endif
+#ifndef IPC_POOL_CLASS_MAX
+#define IPC_POOL_CLASS_MAX      4                       /*!< Number of block sizes the message pool can have */
+#endif
+#ifndef IPC_DEFAULT_STORAGE_CNT
+#define IPC_DEFAULT_STORAGE_CNT 2                       /*!< Static queues of IPC_createHandler() without configSUPPORT_DYNAMIC_ALLOCATION */
+#endif
+
+#ifndef IPC_COPY
+#define IPC_COPY( dst, src, len )   IPC_copy( (dst), (src), (len) ) /*!< Payload copy, can be replaced by an optimized memcpy */
+#endif
+
+/**
+* Allocation of the slots of IPC_createHandler(). aHandle is the receiver task,
+* so on an SMP system the storage can be taken from the memory bank closest to
+* the core the receiver is pinned to (see vTaskCoreAffinityGet()). Both macros
+* can be replaced on their own. Without configSUPPORT_DYNAMIC_ALLOCATION they
+* aren't used, the slots come from IPC_DEFAULT_STORAGE_CNT static queues.
+*/
+#ifndef IPC_STORAGE_MALLOC
+#define IPC_STORAGE_MALLOC( size, aHandle )     pvPortMalloc( size )
+#endif
+#ifndef IPC_STORAGE_FREE
+#define IPC_STORAGE_FREE( ptr )                 vPortFree( ptr )
+#endif
+
+/**
+* Payload copy of IPC_send() by a DMA engine. IPC_DMA_START( dst, src, len, aRecv )
+* must be provided by the port. It starts a memory to memory transfer and
+* returns pdPASS, anything else lets the CPU copy instead. The completion
+* interrupt calls IPC_sendCommitFromISR( aRecv ), i.e. the callback that was
+* registered with EDMA_SetCallback() on i.MX RT.
+*/
+#if (IPC_USE_DMA == 1)
+#ifndef IPC_DMA_START
+#error "IPC_USE_DMA needs IPC_DMA_START( dst, src, len, aRecv )"
+#endif
+#define IPC_DMA_DONE( psHandler )   IPC_dmaDone( psHandler )
+#else
+#define IPC_DMA_DONE( psHandler )
+#endif
+
+#define IPC_SLOT( queue, idx )  ((IPC_sMsg_t *) &((queue)->msgQueue[IPC_slotIdx( (queue), (idx) ) * (queue)->slotSize + IPC_SLOT_HDR_SIZE]))
+#define IPC_SLOT_HDR( psMsg )   ((IPC_sSlotHdr_t *) ((uint8_t *) (psMsg) - IPC_SLOT_HDR_SIZE))
+#define IPC_BLOCK_HDR( psMsg )  ((IPC_sBlockHdr_t *) ((uint8_t *) (psMsg) - IPC_SLOT_HDR_SIZE))
+#define IPC_BLOCK( pool, idx )  ((IPC_sMsg_t *) &((pool)->storage[(idx) * (pool)->slotSize + IPC_SLOT_HDR_SIZE]))
+
+/**
+* Atomic compare-and-swap of a uint32_t, returns true if *ptr was expected and
+* has been replaced by desired. The GCC builtin compiles to LDREX/STREX on
+* ARMv7-M; ports for cores without exclusive access (i.e. Cortex-M0) have to
+* provide their own implementation.
+*/
+#ifndef IPC_ATOMIC_CAS
+#define IPC_ATOMIC_CAS( ptr, expected, desired )    __sync_bool_compare_and_swap( (ptr), (expected), (desired) )
+#endif
+
+/**
+* Short critical section that can be used from tasks and ISRs. The MPSC slot
+* claim and the overwrite policy need it. IPC_ENTER_CRITICAL() declares a
+* variable, so use it once per block.
+*/
+#ifndef IPC_ENTER_CRITICAL
+#define IPC_ENTER_CRITICAL()    UBaseType_t uxIpcSavedMask = portSET_INTERRUPT_MASK_FROM_ISR()
+#define IPC_EXIT_CRITICAL()     portCLEAR_INTERRUPT_MASK_FROM_ISR( uxIpcSavedMask )
+#endif
+
+/**
+* On an SMP kernel masking interrupts only keeps out the own core, so the queues
+* that need a critical section also take a spinlock of their own. The default
+* spins on IPC_ATOMIC_CAS(), cores without exclusive access can map it to a
+* hardware spinlock (i.e. the SIO spinlocks of the RP2040). IPC_QUEUE_LOCK()
+* declares a variable like IPC_ENTER_CRITICAL().
+*/
+#if (IPC_USE_SMP == 1)
+#ifndef IPC_SPIN_LOCK
+#define IPC_SPIN_LOCK( pLock )      while (!IPC_ATOMIC_CAS( (pLock), 0, 1 )) {}
+#define IPC_SPIN_UNLOCK( pLock )    do { IPC_MEMORY_BARRIER(); *(pLock) = 0; } while (0)
+#endif
+#define IPC_QUEUE_LOCK( queue )     IPC_ENTER_CRITICAL(); IPC_SPIN_LOCK( &((queue)->lock) )
+#define IPC_QUEUE_UNLOCK( queue )   IPC_SPIN_UNLOCK( &((queue)->lock) ); IPC_EXIT_CRITICAL()
+#else
+#define IPC_QUEUE_LOCK( queue )     IPC_ENTER_CRITICAL()
+#define IPC_QUEUE_UNLOCK( queue )   IPC_EXIT_CRITICAL()
+#endif
+
+/**
+* Serializes the creation of handlers and subscriptions, which append to tables
+* that tasks on all cores read. taskENTER_CRITICAL() of an SMP kernel holds off
+* the other cores as well. Only used from tasks, never from the send or receive
+* path.
+*/
+#ifndef IPC_CREATE_LOCK
+#define IPC_CREATE_LOCK()       taskENTER_CRITICAL()
+#define IPC_CREATE_UNLOCK()     taskEXIT_CRITICAL()
+#endif
+
+/**
+* Orders the payload accesses against the index that publishes them, so the
+* other side never sees an index before the data it refers to. On Cortex-M
+* this is a DMB.
+*/
+#ifndef IPC_MEMORY_BARRIER
+#if defined(__GNUC__)
+#define IPC_MEMORY_BARRIER()    __sync_synchronize()
+#else
+#define IPC_MEMORY_BARRIER()    __DMB()
+#endif
+#endif
+
+/**
+* Task notification calls on the notification index of a handler. Indexed
+* notifications exist since FreeRTOS V10.4.0, older kernels only have index 0.
+*/
+#if defined(configTASK_NOTIFICATION_ARRAY_ENTRIES)
+#define IPC_NOTIFY_INDEX_CNT    configTASK_NOTIFICATION_ARRAY_ENTRIES
+#define IPC_NOTIFY_GIVE( psHandler ) \
+    xTaskNotifyGiveIndexed( (psHandler)->handle, (psHandler)->notifyIndex )
+#define IPC_NOTIFY_GIVE_FROM_ISR( psHandler, pxWoken ) \
+    vTaskNotifyGiveIndexedFromISR( (psHandler)->handle, (psHandler)->notifyIndex, (pxWoken) )
+#define IPC_NOTIFY_TAKE( psHandler, xClear, xTicks ) \
+    ulTaskNotifyTakeIndexed( (psHandler)->notifyIndex, (xClear), (xTicks) )
+#define IPC_NOTIFY_BITS( psHandler ) \
+    xTaskNotifyIndexed( (psHandler)->handle, (psHandler)->notifyIndex, (psHandler)->notifyBits, eSetBits )
+#define IPC_NOTIFY_BITS_FROM_ISR( psHandler, pxWoken ) \
+    xTaskNotifyIndexedFromISR( (psHandler)->handle, (psHandler)->notifyIndex, (psHandler)->notifyBits, eSetBits, (pxWoken) )
+#define IPC_NOTIFY_WAIT( psHandler, xTicks ) \
+    xTaskNotifyWaitIndexed( (psHandler)->notifyIndex, 0, UINT32_MAX, NULL, (xTicks) )
+#else
+#define IPC_NOTIFY_INDEX_CNT    1
+#define IPC_NOTIFY_GIVE( psHandler )                    xTaskNotifyGive( (psHandler)->handle )
+#define IPC_NOTIFY_GIVE_FROM_ISR( psHandler, pxWoken )  vTaskNotifyGiveFromISR( (psHandler)->handle, (pxWoken) )
+#define IPC_NOTIFY_TAKE( psHandler, xClear, xTicks )    ulTaskNotifyTake( (xClear), (xTicks) )
+#define IPC_NOTIFY_BITS( psHandler ) \
+    xTaskNotify( (psHandler)->handle, (psHandler)->notifyBits, eSetBits )
+#define IPC_NOTIFY_BITS_FROM_ISR( psHandler, pxWoken ) \
+    xTaskNotifyFromISR( (psHandler)->handle, (psHandler)->notifyBits, eSetBits, (pxWoken) )
+#define IPC_NOTIFY_WAIT( psHandler, xTicks )            xTaskNotifyWait( 0, UINT32_MAX, NULL, (xTicks) )
+#endif
+
+/**
+* Notification of a task that waits for space or in IPC_call(). The default is
+* the last index of the kernel. It must not be the index of a handler, else the
+* wait would clear the handler's count and its messages would end the wait, so
+* IPC_setNotifyIndex() refuses it. A task only waits for one of them at a time.
+* With a single index (configTASK_NOTIFICATION_ARRAY_ENTRIES of 1, the kernel
+* default, or a kernel without indexed notifications) it is index 0 of every
+* handler, so IPC_call() doesn't compile then and waiting senders check for
+* space once per tick instead of sleeping until they are woken.
+*/
+#ifndef IPC_WAIT_NOTIFY_INDEX
+#define IPC_WAIT_NOTIFY_INDEX   (IPC_NOTIFY_INDEX_CNT - 1)
+#endif
+#define IPC_WAIT_OWN_INDEX      (IPC_NOTIFY_INDEX_CNT > 1 && IPC_WAIT_NOTIFY_INDEX != IPC_NOTIFY_INDEX)   /*!< Waits don't share a handler's index */
+#if (IPC_USE_RPC == 1) && (IPC_NOTIFY_INDEX_CNT < 2 || IPC_WAIT_NOTIFY_INDEX == IPC_NOTIFY_INDEX)
+#error "IPC_USE_RPC needs configTASK_NOTIFICATION_ARRAY_ENTRIES >= 2 and an IPC_WAIT_NOTIFY_INDEX other than IPC_NOTIFY_INDEX"
+#endif
+#if defined(configTASK_NOTIFICATION_ARRAY_ENTRIES)
+#define IPC_WAIT_GIVE( xTask )  xTaskNotifyGiveIndexed( (xTask), IPC_WAIT_NOTIFY_INDEX )
+#define IPC_WAIT_GIVE_FROM_ISR( xTask, pxWoken ) \
+    vTaskNotifyGiveIndexedFromISR( (xTask), IPC_WAIT_NOTIFY_INDEX, (pxWoken) )
+#define IPC_WAIT_TAKE( xTicks ) ulTaskNotifyTakeIndexed( IPC_WAIT_NOTIFY_INDEX, pdTRUE, (xTicks) )
+#else
+#define IPC_WAIT_GIVE( xTask )  xTaskNotifyGive( xTask )
+#define IPC_WAIT_GIVE_FROM_ISR( xTask, pxWoken )    vTaskNotifyGiveFromISR( (xTask), (pxWoken) )
+#define IPC_WAIT_TAKE( xTicks ) ulTaskNotifyTake( pdTRUE, (xTicks) )
+#endif
+
+#if (IPC_USE_RPC == 1)
+#define IPC_CALL_FREE           0UL         /*!< State of a call slot nobody uses */
+#define IPC_CALL_RESERVED       1UL         /*!< State of a call slot whose request isn't sent yet */
+#define IPC_CALL_REPLYING       2UL         /*!< State of a call slot IPC_reply() is writing the reply for */
+#define IPC_CALL_DONE           3UL         /*!< State of a call slot whose reply is complete */
+#define IPC_CALL_ID( idx, seq ) ((((seq) & 0xFFFFFFUL) << 8) | (idx))  /*!< Call ID of a request, the state while it waits */
+#endif
+
+/**
+* Timestamp of the statistics build. The default reads the DWT cycle counter of
+* Cortex-M3/M4/M7, which IPC_initIPCHandler() enables. Define both macros for
+* other cores or host builds, IPC_GET_TIMESTAMP() has to return a free running
+* 32 bit counter.
+*/
+#if (IPC_USE_STATS == 1)
+#ifndef IPC_GET_TIMESTAMP
+#define IPC_DEMCR               (*(volatile uint32_t *) 0xE000EDFCUL)   /*!< Debug exception and monitor control */
+#define IPC_DWT_CTRL            (*(volatile uint32_t *) 0xE0001000UL)
+#define IPC_DWT_CYCCNT          (*(volatile uint32_t *) 0xE0001004UL)
+#define IPC_DWT_LAR             (*(volatile uint32_t *) 0xE0001FB0UL)   /*!< Lock access register (Cortex-M7) */
+#define IPC_GET_TIMESTAMP()     IPC_DWT_CYCCNT
+#define IPC_TIMESTAMP_INIT()    do { IPC_DEMCR |= (1UL << 24); IPC_DWT_LAR = 0xC5ACCE55UL; IPC_DWT_CTRL |= 1UL; } while (0)
+#endif
+#ifndef IPC_TIMESTAMP_INIT
+#define IPC_TIMESTAMP_INIT()
+#endif
+#define IPC_STATS_STAMP( psHandler, psMsg )     IPC_statsStamp( (psHandler), (psMsg) )
+#define IPC_STATS_SENT( psHandler )             IPC_statsSent( psHandler )
+#define IPC_STATS_RECEIVED( psHandler, psMsg )  IPC_statsReceived( (psHandler), (psMsg) )
+#define IPC_STATS_ADD( counter )                IPC_statsAdd( &(counter) )
+#else
+#define IPC_STATS_STAMP( psHandler, psMsg )
+#define IPC_STATS_SENT( psHandler )
+#define IPC_STATS_RECEIVED( psHandler, psMsg )
+#define IPC_STATS_ADD( counter )
+#endif
+
+/**
+* Cross-core handlers and DMA copies. IPC_REMOTE_NOTIFY( aTaskID ) must be provided by the
+* port and raise an interrupt on the other core that calls
+* IPC_remoteNotifyFromISR( aTaskID ), i.e. on i.MX RT1170 send aTaskID with
+* MU_SendMsgNonBlocking(). It may be called from ISRs.
+* The cache maintenance defaults to the CMSIS functions if the core has a
+* D-cache. Define both as empty if the shared memory isn't cacheable.
+*/
+#if (IPC_USE_MULTICORE == 1) || (IPC_USE_DMA == 1)
+#ifndef IPC_CACHE_CLEAN
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+#define IPC_CACHE_CLEAN( addr, len )        SCB_CleanDCache_by_Addr( (void *) (addr), (int32_t) (len) )
+#define IPC_CACHE_INVALIDATE( addr, len )   SCB_InvalidateDCache_by_Addr( (void *) (addr), (int32_t) (len) )
+#else
+#define IPC_CACHE_CLEAN( addr, len )
+#define IPC_CACHE_INVALIDATE( addr, len )
+#endif
+#endif
+#endif
+#if (IPC_USE_MULTICORE == 1)
+#ifndef IPC_REMOTE_NOTIFY
+#error "IPC_USE_MULTICORE needs IPC_REMOTE_NOTIFY( aTaskID )"
+#endif
+#define IPC_LANE( psHandler, l )                ((psHandler)->apLane[l])
+#define IPC_IS_SHARED( psHandler )              ((psHandler)->shared)
+#define IPC_SHARED_FETCH( psHandler, queue ) \
+    do { if ((psHandler)->shared) IPC_sharedFetch( (psHandler), (queue) ); } while (0)
+#define IPC_SHARED_PUBLISH( psHandler, queue ) \
+    do { if ((psHandler)->shared) IPC_sharedPublish( (psHandler), (queue) ); } while (0)
+#define IPC_SHARED_FETCH_MSG( psHandler, queue, psMsg ) \
+    do { if ((psHandler)->shared) IPC_sharedFetchMsg( (queue), (psMsg) ); } while (0)
+#define IPC_SHARED_PUBLISH_MSG( psHandler, psMsg ) \
+    do { if ((psHandler)->shared) IPC_sharedPublishMsg( psMsg ); } while (0)
+#define IPC_SHARED_WAITING( psHandler, aWaiting ) \
+    do { if ((psHandler)->shared) IPC_sharedWaiting( (psHandler), (aWaiting) ); } while (0)
+#define IPC_SHARED_WAKE_SENDER( psHandler ) \
+    do { if ((psHandler)->shared) IPC_sharedWakeSender( psHandler ); } while (0)
+#else
+#define IPC_LANE( psHandler, l )                (&(psHandler)->lane[l])
+#define IPC_IS_SHARED( psHandler )              0
+#define IPC_SHARED_FETCH( psHandler, queue )
+#define IPC_SHARED_PUBLISH( psHandler, queue )
+#define IPC_SHARED_FETCH_MSG( psHandler, queue, psMsg )
+#define IPC_SHARED_PUBLISH_MSG( psHandler, psMsg )
+#define IPC_SHARED_WAITING( psHandler, aWaiting )
+#define IPC_SHARED_WAKE_SENDER( psHandler )
+#endif
+
+#define IPC_MBOX_NEW            0x4UL       /*!< Flag of the mailbox middle buffer: not taken by the receiver yet */
+#define IPC_MBOX_IDX_MASK       0x3UL       /*!< Buffer index bits of the mailbox indices */
+#define IPC_MBOX( mbox, idx )   ((IPC_sMsg_t *) &((mbox)->storage[(idx) * (mbox)->slotSize + IPC_SLOT_HDR_SIZE]))
+#define IPC_RING_WRAP_MARKER    UINT32_MAX  /*!< u32DataLen of a record that tells the reader to wrap around */
+#define IPC_POOL_NONE           UINT8_MAX   /*!< poolClass of a block that doesn't belong to the message pool */
+#define IPC_POOL_IDX_NONE       UINT16_MAX  /*!< Block index of an empty free list */
+#define IPC_POOL_HEAD( head, idx )  ((uint32_t) (((head) + 0x10000UL) & 0xFFFF0000UL) | (idx))  /*!< Next free list head word */
+
+/**
+* The storage backend of a handler
+*/
+typedef enum
+{
+    E_IPC_QUEUE_SLOTS,  /*!< Fixed size slots of IPC_sMsg_t */
+    E_IPC_QUEUE_RING,   /*!< Length prefixed records in a byte ring */
+    E_IPC_QUEUE_MAILBOX,/*!< Triple buffer that only keeps the latest message */
+} IPC_eQueueKind_t;
+
+/**
+* A FIFO queue of IPC messages
+* The messages are stored in slots of IPC_SLOT_SIZE( maxDataLen ) bytes, so a
+* slot only has room for the largest payload this handler accepts.
+*
+* The queue is a lock-free single-producer/single-consumer ring: only the
+* sender writes queueTail and only the receiver writes queueHead. Both count
+* from 0 to 2 * queueLength - 1, so a full and an empty queue can be told apart
+* without a shared element counter and without wasting a slot.
+*
+* In E_IPC_QUEUE_MODE_MPSC several senders share queueTail. A sender claims a
+* slot with a compare-and-swap on queueTail, copies the payload outside of any
+* critical section and then sets the slot's ready flag. The receiver only
+* takes a slot once its ready flag is set, so slots are consumed in claim order
+* even if a later sender finishes first. The claim itself runs with interrupts
+* masked: a sender preempted between reading queueTail and the
+* compare-and-swap could otherwise succeed after the other senders have moved
+* the index once around, and overwrite a slot the receiver hasn't taken yet.
+*
+* With E_IPC_OVERFLOW_OVERWRITE the sender drops the oldest message of a full
+* queue by moving queueHead. Only for these handlers, head updates and the
+* borrowed flag are protected by a short critical section, which on an SMP
+* kernel also takes the queue's spinlock. All other paths are lock-free on
+* any number of cores, as they only rely on the index ownership, the
+* compare-and-swap and IPC_MEMORY_BARRIER().
+*
+* A handler can have up to IPC_LANE_CNT of these queues. Each message type is
+* mapped to one lane and the receiver always takes the messages of the highest
+* non-empty lane first.
+*/
+typedef struct
+{
+    volatile uint32_t   ready;          /*!< Message in this slot is complete (E_IPC_QUEUE_MODE_MPSC) */
+    IPC_sMsg_t *        ref;            /*!< Block this slot refers to, NULL if the slot holds the message itself */
+} IPC_sSlotHdr_t;
+
+/**
+* Header of a message block of a topic or of the message pool
+* refCnt counts the queues that still refer to the block. The block is free
+* again once it drops to 0; pool blocks then go back to their free list, where
+* refCnt links to the next free block instead.
+*/
+typedef struct
+{
+    volatile uint32_t   refCnt;         /*!< Number of references, index of the next free block while on the free list */
+    uint16_t            blockIdx;       /*!< Index of this block in its pool class */
+    uint8_t             poolClass;      /*!< Pool class of this block, IPC_POOL_NONE for topic blocks */
+} IPC_sBlockHdr_t;
+
+/**
+* A size class of the message pool
+* Free blocks are kept on a lock-free stack. freeHead holds the index of the
+* first free block in the low half and a counter in the high half, which is
+* incremented on every change so a compare-and-swap can't succeed on a stale
+* head (ABA).
+*/
+typedef struct
+{
+    uint8_t *           storage;        /*!< Storage of blockCnt blocks */
+    uint32_t            slotSize;       /*!< Size of a block in bytes */
+    uint32_t            maxDataLen;     /*!< The maximum data size of a block */
+    uint32_t            blockCnt;       /*!< Number of blocks */
+    volatile uint32_t   freeHead;       /*!< Counter << 16 | index of the first free block */
+} IPC_sPoolClass_t;
 
 /**
 * A FIFO queue of IPC messages
+* The fields set at creation, the sender's index and the receiver's index are
+* on separate cache lines, so an index update doesn't evict the other side's
+* line.
 */
 typedef struct
 {
-    IPC_sMsg_t      msgQueue[IPC_MSG_QUEUE_LENGTH]; /*!< Array of messages */
-    uint8_t         queueTail;                      /*!< Last written message */
-    uint8_t         queueHead;                      /*!< First to read message */
-    uint8_t         queueSize;                      /*!< Elements inside the queue (diff(tail, head)) */
+    uint8_t *           msgQueue;       /*!< Storage of queueLength message slots */
+    uint32_t            multiProducer;  /*!< E_IPC_QUEUE_MODE_MPSC: senders claim slots by CAS on queueTail */
+    uint32_t            slotSize;       /*!< Size of a message slot in bytes */
+    uint32_t            maxDataLen;     /*!< The maximum data size of a message */
+    uint32_t            queueLength;    /*!< Number of message slots */
+    volatile uint32_t   queueTail IPC_ALIGNED( IPC_CACHE_LINE_SIZE );  /*!< Next message to write, only written by the sender */
+#if (IPC_USE_MULTICORE == 1)
+    volatile uint32_t   senderWaiting;  /*!< The sender of a shared handler waits for space, on the sender's cache line */
+#endif
+    volatile uint32_t   queueHead IPC_ALIGNED( IPC_CACHE_LINE_SIZE );  /*!< First to read message, only written by the receiver */
+    volatile uint32_t   borrowed;       /*!< The receiver is reading the head slot (E_IPC_OVERFLOW_OVERWRITE) */
+#if (IPC_USE_SMP == 1)
+    volatile uint32_t   lock;           /*!< Spinlock of IPC_QUEUE_LOCK(), only for E_IPC_OVERFLOW_OVERWRITE */
+#endif
 } IPC_sMsgQueue_t;
 
 /**
-* An IPC handler
+* A FIFO queue of variable length messages
+* Every record is a message header followed by u32DataLen bytes of payload,
+* padded to IPC_RING_ALIGN bytes. A record is never split at the end of the
+* buffer: if it doesn't fit, a wrap marker is written and the record starts
+* at offset 0. Head and tail are only equal when the ring is empty.
+* Like the slot queue, only the sender writes ringTail and only the receiver
+* writes ringHead, each on its own cache line.
+*/
+typedef struct
+{
+    uint8_t *           ringBuf;    /*!< Caller provided, word aligned buffer */
+    uint32_t            ringSize;   /*!< Size of ringBuf in bytes */
+    volatile uint32_t   ringTail IPC_ALIGNED( IPC_CACHE_LINE_SIZE );   /*!< Offset of the next record to write */
+    uint32_t            ringNext;   /*!< Tail offset after the reserved record has been committed */
+    volatile uint32_t   ringHead IPC_ALIGNED( IPC_CACHE_LINE_SIZE );   /*!< Offset of the first record to read */
+} IPC_sByteRing_t;
+
+/**
+* A mailbox that only keeps the latest message
+* A triple buffer: the sender writes the back buffer, the receiver reads the
+* front buffer and the newest complete message waits in the middle. Each side
+* swaps its buffer with the middle by compare-and-swap, so neither ever waits
+* and a message is never copied twice. The buffers use the slot layout, but
+* their slot headers are unused.
+*/
+typedef struct
+{
+    uint8_t *           storage;    /*!< Storage of 3 buffers */
+    uint32_t            slotSize;   /*!< Size of a buffer in bytes */
+    uint32_t            maxDataLen; /*!< The maximum data size of a message */
+    volatile uint32_t   middle IPC_ALIGNED( IPC_CACHE_LINE_SIZE );     /*!< Middle buffer index | IPC_MBOX_NEW */
+    uint32_t            back;       /*!< Buffer the sender writes, only used by the sender */
+    uint32_t            front IPC_ALIGNED( IPC_CACHE_LINE_SIZE );      /*!< Buffer the receiver reads, only used by the receiver */
+    uint32_t            unread;     /*!< The front buffer holds a message that hasn't been released */
+} IPC_sMailbox_t;
+
+#if (IPC_USE_STATS == 1)
+/**
+* Counters of a handler
+* The sender side counters can be changed by several senders at once, so they
+* are only changed by compare-and-swap. The receiver side is only written by
+* the receiver.
 */
 typedef struct
 {
-    IPC_eTaskID_t   recvId; /*!< ID of the receiver task */
-    TaskHandle_t    handle; /*!< TaskHandle_t of the receiver task */
-    IPC_sMsgQueue_t queue;  /*!< Message queue */
+    volatile uint32_t   sent;           /*!< Messages committed to the queue */
+    volatile uint32_t   dropped;        /*!< Messages dropped by E_IPC_OVERFLOW_OVERWRITE */
+    volatile uint32_t   rejected;       /*!< Sends that found the queue full */
+    volatile uint32_t   highWater;      /*!< Max. number of queued messages (bytes for the byte ring) */
+    uint32_t            received IPC_ALIGNED( IPC_CACHE_LINE_SIZE );   /*!< Messages released by the receiver */
+    uint32_t            latencyMin;     /*!< Min. time from commit to release */
+    uint32_t            latencyMax;     /*!< Max. time from commit to release */
+    uint64_t            latencySum;     /*!< Sum of all latencies for the average */
+} IPC_sStatCnt_t;
+#endif
+
+/**
+* An IPC handler
+*/
+typedef struct IPC_sHandler_t
+{
+    IPC_eTaskID_t       recvId;     /*!< ID of the receiver task */
+    TaskHandle_t        handle;     /*!< TaskHandle_t of the receiver task */
+    UBaseType_t         notifyIndex;/*!< Task notification index the receiver is notified on */
+    uint32_t            notifyBits; /*!< Notification bit set for IPC_select(), 0 to increment the count */
+    IPC_eQueueKind_t    kind;       /*!< Storage backend in use */
+    IPC_eOverflowPolicy_t policy;   /*!< What IPC_send() does if the queue is full */
+    TickType_t          blockTicks; /*!< Max. time to wait for space (E_IPC_OVERFLOW_BLOCK) */
+    volatile uint32_t   reserved;   /*!< A message is reserved by IPC_sendReserve() */
+    IPC_sMsg_t *        reservedMsg;/*!< Message reserved by IPC_sendReserve() */
+    volatile uint32_t   notifyPending;  /*!< Messages were sent by IPC_sendDeferred() since the last IPC_flush() */
+#if (IPC_USE_DMA == 1)
+    uint32_t            dmaThreshold;   /*!< Min. payload size IPC_send() copies by DMA, 0 if it never does */
+    volatile uint32_t   dmaLen;         /*!< Payload size of the reserved message a DMA is writing, 0 if none */
+#endif
+    uint32_t            recvLane;   /*!< Lane of the messages the receiver is reading */
+    uint8_t             typeLane[E_IPC_MSG_TYPE_CNT];   /*!< Lane of each message type */
+    IPC_pfnCallback_t   callback[E_IPC_MSG_TYPE_CNT];   /*!< Callback of each message type for IPC_dispatch() */
+    IPC_sMsgQueue_t     lane[IPC_LANE_CNT]; /*!< Message queue of each lane, highest priority last (E_IPC_QUEUE_SLOTS) */
+#if (IPC_USE_MULTICORE == 1)
+    IPC_sMsgQueue_t *   apLane[IPC_LANE_CNT];   /*!< Queue of each lane, lane 0 of a shared handler is in the shared memory */
+    uint32_t            shared;     /*!< The queue is shared with another core, handle is NULL on the sender's core */
+#endif
+    IPC_sByteRing_t     ring;       /*!< Byte ring (E_IPC_QUEUE_RING) */
+    IPC_sMailbox_t      mbox;       /*!< Triple buffer (E_IPC_QUEUE_MAILBOX) */
+    volatile uint32_t   waiters;    /*!< Senders in IPC_sWaitList that wait for this handler's lanes */
+#if (IPC_USE_STATS == 1)
+    IPC_sStatCnt_t      stats;      /*!< Counters for IPC_getStats() */
+#endif
 } IPC_sHandler_t;
 
+/**
+* A sender waiting for space
+* Senders that block register here and are woken by the receiver once the lane
+* of their message type has enough credits. A sender that also needs a block of
+* the message pool is woken by the release of any handler, as the block can
+* come back from any of them.
+*/
+typedef struct
+{
+    TaskHandle_t        task;       /*!< Waiting sender, NULL if the entry is free */
+    IPC_sHandler_t *    handler;    /*!< Handler it sends to */
+    IPC_eMsgType_t      type;       /*!< Message type it wants to send */
+    uint32_t            need;       /*!< Credits it waits for */
+    uint32_t            poolLen;    /*!< Payload size of the pool block it waits for, 0 if it needs none */
+} IPC_sWaiter_t;
+
+/**
+* The waiting senders of all handlers
+* Registration and wakeup take IPC_QUEUE_LOCK(), the receiver only checks the
+* counts without it.
+*/
+typedef struct
+{
+    IPC_sWaiter_t       entry[IPC_WAITER_MAX];  /*!< Registered senders */
+    volatile uint32_t   poolCnt;    /*!< Entries waiting for a pool block */
+#if (IPC_USE_SMP == 1)
+    volatile uint32_t   lock;       /*!< Spinlock of IPC_QUEUE_LOCK() */
+#endif
+} IPC_sWaitList_t;
+
+/**
+* A publish/subscribe topic
+*/
+typedef struct
+{
+    uint8_t *           pool;           /*!< Storage of poolLength messages, NULL if the topic doesn't exist */
+    uint32_t            slotSize;       /*!< Size of a pool entry in bytes */
+    uint32_t            maxDataLen;     /*!< The maximum data size of a message */
+    uint32_t            poolLength;     /*!< Number of pool entries */
+    uint32_t            nextFree;       /*!< Pool entry to try first on the next publish */
+    uint32_t            subCnt;         /*!< Number of subscribers */
+    IPC_sHandler_t *    apSub[IPC_TOPIC_SUB_MAX];   /*!< Handlers of the subscribers */
+} IPC_sTopic_t;
+
+#if (IPC_USE_RPC == 1)
+/**
+* A request of IPC_call() waiting for its reply
+* The state is the call ID while the caller waits. IPC_reply() and the timeout
+* of the caller both compare-and-swap it away, so only one of them wins.
+*/
+typedef struct
+{
+    volatile uint32_t   state;      /*!< IPC_CALL_xxx or the call ID of the request */
+    uint32_t            seq;        /*!< Sequence number of the last request of this slot */
+    TaskHandle_t        caller;     /*!< Task that waits for the reply */
+    IPC_sMsg_t *        resp;       /*!< Buffer of the reply */
+} IPC_sCall_t;
+#endif
+
 
 /*******************************************************************************
  * Static Prototypes
  ******************************************************************************/
-static int IPC_getHandlerIdx( IPC_eTaskID_t );
+static inline IPC_sHandler_t * IPC_getHandler( IPC_eTaskID_t );
+static IPC_eError_t IPC_checkNewHandler( IPC_eTaskID_t );
+static IPC_sHandler_t * IPC_addHandler( IPC_eTaskID_t, TaskHandle_t, IPC_eQueueKind_t );
+static void IPC_publishHandler( IPC_sHandler_t * );
+static IPC_eError_t IPC_addSlotHandler( IPC_eTaskID_t, TaskHandle_t, uint32_t, uint32_t, uint8_t * );
+static void IPC_initQueue( IPC_sMsgQueue_t *, uint32_t, uint32_t, uint8_t * );
+static inline IPC_sMsgQueue_t * IPC_typeQueue( IPC_sHandler_t *, IPC_eMsgType_t );
+static inline IPC_sMsgQueue_t * IPC_slotQueue( IPC_sHandler_t *, const IPC_sMsg_t * );
+static uint32_t IPC_recvLane( const IPC_sHandler_t * );
+static uint32_t IPC_slotCount( const IPC_sHandler_t * );
+static inline uint32_t IPC_slotIdx( const IPC_sMsgQueue_t *, uint32_t );
+static inline uint32_t IPC_nextIdx( const IPC_sMsgQueue_t *, uint32_t );
+static inline uint32_t IPC_queueCount( const IPC_sMsgQueue_t *, uint32_t, uint32_t );
+static IPC_eError_t IPC_queueReserve( IPC_sHandler_t *, IPC_eMsgType_t, uint32_t, IPC_sMsg_t ** );
+static IPC_eError_t IPC_queueReserveWait( IPC_sHandler_t *, IPC_eMsgType_t, uint32_t, IPC_sMsg_t ** );
+static uint32_t IPC_dropOldest( IPC_sHandler_t *, IPC_sMsgQueue_t * );
+static inline uint32_t IPC_isTailReserved( const IPC_sHandler_t * );
+static void IPC_queueCommit( IPC_sHandler_t *, IPC_sMsg_t * );
+static IPC_eError_t IPC_notify( IPC_sHandler_t * );
+static void IPC_notifyFromISR( IPC_sHandler_t *, BaseType_t * );
+static uint32_t IPC_hasData( const IPC_sHandler_t * );
+static uint32_t IPC_selectReady( TaskHandle_t, uint32_t, IPC_sHandler_t ** );
+static IPC_eError_t IPC_queuePeek( IPC_sHandler_t *, IPC_sMsg_t ** );
+static IPC_eError_t IPC_queuePeekLane( IPC_sHandler_t *, IPC_sMsg_t ** );
+static IPC_eError_t IPC_queueRelease( IPC_sHandler_t * );
+static uint32_t IPC_queuePeekBatch( IPC_sHandler_t *, IPC_sMsg_t **, uint32_t );
+static IPC_eError_t IPC_queueReleaseBatch( IPC_sHandler_t *, uint32_t );
+static uint32_t IPC_queueHasMore( IPC_sHandler_t *, uint32_t );
+static uint32_t IPC_ringNextRecord( const IPC_sByteRing_t *, uint32_t, IPC_sMsg_t ** );
+static IPC_eError_t IPC_ringReserve( IPC_sByteRing_t *, uint32_t, IPC_sMsg_t ** );
+static IPC_eError_t IPC_ringPeek( IPC_sByteRing_t *, IPC_sMsg_t ** );
+static IPC_eError_t IPC_ringRelease( IPC_sByteRing_t * );
+static void IPC_mboxCommit( IPC_sHandler_t * );
+static uint32_t IPC_credits( IPC_sHandler_t *, IPC_eMsgType_t );
+static uint32_t IPC_spaceReady( IPC_sHandler_t *, IPC_eMsgType_t, uint32_t, uint32_t );
+static IPC_eError_t IPC_spaceWait( IPC_sHandler_t *, IPC_eMsgType_t, uint32_t, uint32_t, TickType_t );
+static IPC_sWaiter_t * IPC_waitRegister( IPC_sHandler_t *, IPC_eMsgType_t, uint32_t, uint32_t );
+static void IPC_waitUnregister( IPC_sHandler_t *, IPC_sWaiter_t * );
+static inline void IPC_spaceReturned( IPC_sHandler_t * );
+static void IPC_wakeSenders( IPC_sHandler_t *, BaseType_t * );
+static IPC_eError_t IPC_mboxPeek( IPC_sMailbox_t *, IPC_sMsg_t ** );
+static inline IPC_sMsg_t * IPC_slotMsg( IPC_sMsg_t * );
+static inline IPC_sMsg_t * IPC_queueData( const IPC_sHandler_t *, IPC_sMsg_t * );
+static IPC_eError_t IPC_poolAlloc( uint32_t, IPC_sMsg_t ** );
+static void IPC_poolFree( IPC_sMsg_t * );
+static void IPC_slotClear( IPC_sMsg_t * );
+static void IPC_blockUnref( IPC_sMsg_t *, uint32_t );
+static void IPC_copy( uint8_t *, const uint8_t *, uint32_t );
+static inline IPC_eError_t IPC_sendTo( IPC_sHandler_t *, IPC_eMsgType_t, const uint8_t *, uint32_t );
+#if (IPC_USE_DMA == 1)
+static IPC_eError_t IPC_sendDma( IPC_sHandler_t *, IPC_eMsgType_t, const uint8_t *, uint32_t );
+static void IPC_dmaDone( IPC_sHandler_t * );
+static uint32_t IPC_dmaAligned( const IPC_sHandler_t * );
+#endif
+#if (IPC_USE_MULTICORE == 1) || (IPC_USE_DMA == 1)
+static void IPC_cacheClean( const volatile void *, uint32_t );
+static void IPC_cacheInvalidate( const volatile void *, uint32_t );
+#endif
+#if (IPC_USE_MULTICORE == 1)
+static void IPC_sharedFetch( const IPC_sHandler_t *, const IPC_sMsgQueue_t * );
+static void IPC_sharedPublish( const IPC_sHandler_t *, const IPC_sMsgQueue_t * );
+static void IPC_sharedFetchMsg( const IPC_sMsgQueue_t *, IPC_sMsg_t * );
+static void IPC_sharedPublishMsg( IPC_sMsg_t * );
+static void IPC_sharedWaiting( const IPC_sHandler_t *, uint32_t );
+static void IPC_sharedWakeSender( const IPC_sHandler_t * );
+#endif
+#if (IPC_USE_STATS == 1)
+static void IPC_statsClear( IPC_sHandler_t * );
+static void IPC_statsAdd( volatile uint32_t * );
+static void IPC_statsStamp( const IPC_sHandler_t *, IPC_sMsg_t * );
+static void IPC_statsSent( IPC_sHandler_t * );
+static void IPC_statsReceived( IPC_sHandler_t *, const IPC_sMsg_t * );
+#endif
 
 /*******************************************************************************
  * Static Variables
  ******************************************************************************/
-static IPC_sHandler_t IPC_arHandler[IPC_HANDLER_CNT_MAX];   /*!< Array of IPC handler structures */
-static uint8_t IPC_u8HandlerCnt;                            /*!< Count of initialized handlers */
+#if defined(IPC_TOPOLOGY)
+#define IPC_TOPO_STORAGE( aTaskID, aLength, aMaxLen, aPolicy, xTicks ) \
+    static uint8_t IPC_au8Topo_##aTaskID[IPC_QUEUE_STORAGE_SIZE( aLength, aMaxLen )] IPC_STORAGE_ATTR;
+#define IPC_TOPO_HANDLER( aTaskID, aLength, aMaxLen, aPolicy, xTicks ) \
+    IPC_sHandler_t IPC_sTopo_##aTaskID IPC_SECTION = { .recvId = aTaskID, .notifyIndex = IPC_NOTIFY_INDEX, .policy = aPolicy, .blockTicks = xTicks, \
+        .lane[0] = { .msgQueue = IPC_au8Topo_##aTaskID, .slotSize = IPC_SLOT_SIZE( aMaxLen ), .maxDataLen = aMaxLen, .queueLength = aLength } };
+#define IPC_TOPO_TABLE( aTaskID, aLength, aMaxLen, aPolicy, xTicks ) \
+    [IPC_TOPO_IDX_##aTaskID] = &IPC_sTopo_##aTaskID,
+#define IPC_TOPO_LUT( aTaskID, aLength, aMaxLen, aPolicy, xTicks ) \
+    [aTaskID] = &IPC_sTopo_##aTaskID,
+
+IPC_TOPOLOGY( IPC_TOPO_STORAGE )                                        /* Zeroed slots are empty */
+IPC_TOPOLOGY( IPC_TOPO_HANDLER )                                        /* Named, IPC_SEND_STATIC() takes their address */
+static IPC_sHandler_t * const IPC_apHandler[IPC_HANDLER_CNT_MAX] = { IPC_TOPOLOGY( IPC_TOPO_TABLE ) };
+static IPC_sHandler_t * const IPC_apHandlerLut[IPC_TASK_ID_CNT] = { IPC_TOPOLOGY( IPC_TOPO_LUT ) };
+static uint8_t IPC_u8HandlerCnt IPC_SECTION = IPC_HANDLER_CNT_MAX;      /*!< The table is always full */
+#define IPC_HANDLER_AT( i )     (IPC_apHandler[i])                  /*!< Handler in table entry i */
+#else
+static IPC_sHandler_t IPC_arHandler[IPC_HANDLER_CNT_MAX] IPC_SECTION;   /*!< Array of IPC handler structures */
+#define IPC_HANDLER_AT( i )     (&IPC_arHandler[i])                 /*!< Handler in table entry i */
+static IPC_sHandler_t * IPC_apHandlerLut[IPC_TASK_ID_CNT] IPC_SECTION;  /*!< Handler of each task ID, NULL if there is none */
+static uint8_t IPC_u8HandlerCnt IPC_SECTION;                            /*!< Count of initialized handlers */
+#endif
+static IPC_sTopic_t IPC_arTopic[E_IPC_TOPIC_CNT] IPC_SECTION;           /*!< Publish/subscribe topics */
+static IPC_sPoolClass_t IPC_arPoolClass[IPC_POOL_CLASS_MAX] IPC_SECTION;/*!< Size classes of the message pool, smallest first */
+static uint8_t IPC_u8PoolClassCnt IPC_SECTION;                          /*!< Count of pool size classes */
+static IPC_sWaitList_t IPC_sWaitList IPC_SECTION;                       /*!< Senders waiting for space */
+#if (IPC_USE_RPC == 1)
+static IPC_sCall_t IPC_arCall[IPC_CALL_CNT_MAX] IPC_SECTION;            /*!< Requests waiting for a reply */
+#endif
+#if !defined(IPC_TOPOLOGY) && (configSUPPORT_DYNAMIC_ALLOCATION == 0)
+static uint8_t IPC_au8DefaultStorage[IPC_DEFAULT_STORAGE_CNT][IPC_QUEUE_STORAGE_SIZE( IPC_MSG_QUEUE_LENGTH, IPC_MAX_DATA_LENGTH )] IPC_STORAGE_ATTR;
+static uint8_t IPC_u8DefaultStorageCnt IPC_SECTION;                     /*!< Count of used queues of IPC_au8DefaultStorage */
+#endif
 
 /*******************************************************************************
  * Code
  ******************************************************************************/
 /**
  * Create an IPC handler
- * Each task can have max. one handler and each handler must be initialized by
- * an IPC_createHandler() call
+ * Each task ID can have max. one handler and each handler must be initialized by
+ * an IPC_createHandler() call. The queue has IPC_MSG_QUEUE_LENGTH slots of
+ * IPC_MAX_DATA_LENGTH bytes which are allocated from the FreeRTOS heap. If
+ * configSUPPORT_DYNAMIC_ALLOCATION is 0, they are taken from
+ * IPC_DEFAULT_STORAGE_CNT (2) queues in static memory instead, further
+ * handlers need IPC_createHandlerStatic().
  * @param   aTaskID     Receiver task ID
  * @param   aHandle     Receiver task handle
  * @return  error
  */
 IPC_eError_t IPC_createHandler( IPC_eTaskID_t aTaskID, TaskHandle_t aHandle )
 {
+#if defined(IPC_TOPOLOGY)
+    (void) aTaskID;
+    (void) aHandle;
+    return E_IPC_ERR_INVALID;   // The static topology is fixed, don't allocate storage for it
+#elif (configSUPPORT_DYNAMIC_ALLOCATION == 1)
     if (aHandle == NULL)
     {
         return E_IPC_ERR_CREATE_FAIL;
     }
-    else if (IPC_u8HandlerCnt == IPC_HANDLER_CNT_MAX) // There is no space for more handlers
+    else if (IPC_getHandler( aTaskID ) != NULL)  // A handler already exists for this task ID
+    {
+        return E_IPC_ERR_EXISTS;
+    }
+
+    /* The heap only guarantees portBYTE_ALIGNMENT, so the slots are moved to the next cache line */
+    uint8_t * pu8Storage = IPC_STORAGE_MALLOC( IPC_QUEUE_STORAGE_SIZE( IPC_MSG_QUEUE_LENGTH, IPC_MAX_DATA_LENGTH ) + IPC_CACHE_LINE_SIZE - 1, aHandle );
+    if (pu8Storage == NULL)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    uint8_t * pu8Slots = pu8Storage + ((IPC_CACHE_LINE_SIZE - ((uintptr_t) pu8Storage & (IPC_CACHE_LINE_SIZE - 1))) & (IPC_CACHE_LINE_SIZE - 1));
+
+    IPC_eError_t error = IPC_addSlotHandler( aTaskID, aHandle, IPC_MSG_QUEUE_LENGTH, IPC_MAX_DATA_LENGTH, pu8Slots );
+    if (error != E_IPC_SUCCESS)
+    {
+        IPC_STORAGE_FREE( pu8Storage );
+    }
+    return error;
+#else
+    if (aHandle == NULL)
     {
         return E_IPC_ERR_CREATE_FAIL;
     }
-    else if (IPC_getHandlerIdx( aTaskID ) != -1)  // A handler already exists for this task ID
+    else if (IPC_getHandler( aTaskID ) != NULL)  // A handler already exists for this task ID
     {
         return E_IPC_ERR_EXISTS;
     }
+    else if (IPC_u8DefaultStorageCnt == IPC_DEFAULT_STORAGE_CNT) // All static queues are in use
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+
+    IPC_eError_t error = IPC_addSlotHandler( aTaskID, aHandle, IPC_MSG_QUEUE_LENGTH, IPC_MAX_DATA_LENGTH,
+                                             IPC_au8DefaultStorage[IPC_u8DefaultStorageCnt] );
+    if (error == E_IPC_SUCCESS)
+    {
+        IPC_u8DefaultStorageCnt++;
+    }
+    return error;
+#endif
+}
+
+/**
+ * Create an IPC handler with caller provided storage
+ * Works like IPC_createHandler(), but queue depth and maximum payload size are
+ * chosen per handler and the storage is provided by the caller, the way
+ * xQueueCreateStatic() does it.
+ * @param   aTaskID         Receiver task ID
+ * @param   aHandle         Receiver task handle
+ * @param   aQueueLength    Number of messages the queue can hold
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apStorage       Pointer aligned buffer of IPC_QUEUE_STORAGE_SIZE( aQueueLength, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_createHandlerStatic( IPC_eTaskID_t aTaskID, TaskHandle_t aHandle, uint32_t aQueueLength,
+                                      uint32_t aMaxDataLen, uint8_t * apStorage )
+{
+    if (aHandle == NULL || apStorage == NULL)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (((uintptr_t) apStorage & (sizeof(void *) - 1)) != 0) // Slot headers hold pointers
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
     else
     {
-        /*
-        * Initialize IPC handler
-        */
-        IPC_sHandler_t * psHandler = &IPC_arHandler[IPC_u8HandlerCnt];
-        psHandler->recvId               = aTaskID;
-        psHandler->handle               = aHandle;
-        psHandler->queue.queueSize      = 0;
-        psHandler->queue.queueTail      = 0;
-        psHandler->queue.queueHead      = 0;
-
-        IPC_u8HandlerCnt++;
-        return E_IPC_SUCCESS;
+        return IPC_addSlotHandler( aTaskID, aHandle, aQueueLength, aMaxDataLen, apStorage );
     }
 }
 
 /**
- * Send an IPC message
- * @param   aRecv       Receiver task ID
- * @param   aType       Message type
- * @param   apData      Message data
- * @param   aDataSize   Size of message data in bytes
+ * Create an IPC handler that stores messages in a byte ring
+ * Messages occupy only IPC_RING_RECORD_SIZE( u32DataLen ) bytes instead of a
+ * whole IPC_sMsg_t, so capacity is measured in bytes and small messages are
+ * packed densely. The buffer is provided by the caller, so it can be placed
+ * in any memory region (i.e. DTCM).
+ * @param   aTaskID     Receiver task ID
+ * @param   aHandle     Receiver task handle
+ * @param   apBuf       Word aligned buffer for the records
+ * @param   aBufSize    Size of apBuf in bytes (multiple of IPC_RING_ALIGN)
  * @return  error
  */
-IPC_eError_t IPC_send( IPC_eTaskID_t aRecv, IPC_eMsgType_t aType, uint8_t * apData, int aDataSize )
+IPC_eError_t IPC_createRingHandler( IPC_eTaskID_t aTaskID, TaskHandle_t aHandle, uint8_t * apBuf, uint32_t aBufSize )
 {
-    if (aDataSize >= IPC_MAX_DATA_LENGTH) // Data cannot be sent because it's too large
+    if (aHandle == NULL || apBuf == NULL)
     {
-        return E_IPC_ERR_SEND_FAIL;
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (((uintptr_t) apBuf & (sizeof(uint32_t) - 1)) != 0 || (aBufSize & (IPC_RING_ALIGN - 1)) != 0)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (aBufSize <= IPC_RING_RECORD_SIZE( 0 )) // A single record must always fit
+    {
+        return E_IPC_ERR_CREATE_FAIL;
     }
 
-    uint8_t handlerIdx  = IPC_getHandlerIdx( aRecv );
-    if (handlerIdx == -1) // There is no handler for this task ID
+    IPC_CREATE_LOCK();
+    IPC_eError_t error = IPC_checkNewHandler( aTaskID );
+    if (error == E_IPC_SUCCESS)
     {
-        return E_IPC_ERR_NO_HANDLER;
+        IPC_sHandler_t * psHandler = IPC_addHandler( aTaskID, aHandle, E_IPC_QUEUE_RING );
+        psHandler->ring.ringBuf     = apBuf;
+        psHandler->ring.ringSize    = aBufSize;
+        psHandler->ring.ringTail    = 0;
+        psHandler->ring.ringHead    = 0;
+        psHandler->ring.ringNext    = 0;
+        IPC_publishHandler( psHandler );
     }
+    IPC_CREATE_UNLOCK();
 
-    /* Copy data to message buffer */
-    IPC_sMsgQueue_t * queue = &(IPC_arHandler[handlerIdx].queue);
-    uint8_t idx             = queue->queueTail;
+    return error;
+}
 
-    queue->msgQueue[idx].eIPC_MsgType    = aType;
-    queue->msgQueue[idx].u32DataLen      = aDataSize;
-    for (int i = 0; i < aDataSize; i++)
+/**
+ * Create an IPC handler that only keeps the latest message
+ * For state data where only the newest value matters. The handler is a
+ * lock-free triple buffer: sending never blocks or fails for a full queue, a
+ * newer message replaces the one that hasn't been received yet, and the
+ * receiver always gets the latest complete message. There is one sender per
+ * mailbox. Replaced messages are counted as dropped in IPC_getStats().
+ * @param   aTaskID         Receiver task ID
+ * @param   aHandle         Receiver task handle
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apStorage       Pointer aligned buffer of IPC_MAILBOX_STORAGE_SIZE( aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_createMailboxHandler( IPC_eTaskID_t aTaskID, TaskHandle_t aHandle, uint32_t aMaxDataLen, uint8_t * apStorage )
+{
+    if (aHandle == NULL || apStorage == NULL || aMaxDataLen > IPC_MAX_DATA_LENGTH)
     {
-        queue->msgQueue[idx].u8Data[i]   = apData[i];
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (((uintptr_t) apStorage & (sizeof(void *) - 1)) != 0)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
     }
 
-    queue->queueSize++;
-  
-    /*
-    * Increment tail pointer - don't use modulo because it might be slower
-    */
-    if (queue->queueTail == IPC_MSG_QUEUE_LENGTH - 1)
+    IPC_CREATE_LOCK();
+    IPC_eError_t error = IPC_checkNewHandler( aTaskID );
+    if (error == E_IPC_SUCCESS)
     {
-        queue->queueTail = 0;
+        IPC_sHandler_t * psHandler = IPC_addHandler( aTaskID, aHandle, E_IPC_QUEUE_MAILBOX );
+        psHandler->mbox.storage     = apStorage;
+        psHandler->mbox.slotSize    = IPC_SLOT_SIZE( aMaxDataLen );
+        psHandler->mbox.maxDataLen  = aMaxDataLen;
+        psHandler->mbox.back        = 0;
+        psHandler->mbox.middle      = 1;
+        psHandler->mbox.front       = 2;
+        psHandler->mbox.unread      = 0;
+        IPC_publishHandler( psHandler );
     }
-    else
+    IPC_CREATE_UNLOCK();
+
+    return error;
+}
+
+/**
+ * Create an IPC handler whose queue is in memory shared with another core
+ * Called on the receiver's core, the sender's core attaches to the same memory
+ * with IPC_attachSharedHandler(). The memory must have the same address on
+ * both cores. Cache lines are cleaned and invalidated with IPC_CACHE_CLEAN()
+ * and IPC_CACHE_INVALIDATE(), only for the bytes a message uses. The sender's
+ * core wakes the receiver with IPC_REMOTE_NOTIFY(), i.e. a Messaging Unit
+ * interrupt whose handler calls IPC_remoteNotifyFromISR(). A blocked sender is
+ * woken the same way from the receiver's core. Only one task of the sender's
+ * core may send to this handler, and it only supports the
+ * reject and block overflow policies, lane 0 and payloads up to aMaxDataLen.
+ * Only available if IPC_USE_MULTICORE is 1.
+ * @param   aTaskID         Receiver task ID
+ * @param   aHandle         Receiver task handle
+ * @param   aQueueLength    Number of messages the queue can hold
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apShared        IPC_CACHE_LINE_SIZE aligned buffer of IPC_SHARED_STORAGE_SIZE( aQueueLength, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_createSharedHandler( IPC_eTaskID_t aTaskID, TaskHandle_t aHandle, uint32_t aQueueLength,
+                                      uint32_t aMaxDataLen, uint8_t * apShared )
+{
+#if (IPC_USE_MULTICORE == 1)
+    if (aHandle == NULL || apShared == NULL)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (((uintptr_t) apShared & (IPC_CACHE_LINE_SIZE - 1)) != 0) // Cache maintenance works on whole lines
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (sizeof(IPC_sMsgQueue_t) > IPC_SHARED_HDR_SIZE) // IPC_CACHE_LINE_SIZE is too small for the indices
     {
-        queue->queueTail++;
+        return E_IPC_ERR_CREATE_FAIL;
     }
 
-    if (pdPASS == xTaskNotifyGive( IPC_arHandler[handlerIdx].handle ))  // Notify task
+    else if (aQueueLength == 0 || aMaxDataLen > IPC_MAX_DATA_LENGTH)
     {
-        return E_IPC_SUCCESS;
+        return E_IPC_ERR_CREATE_FAIL;
     }
-    else
+
+    IPC_CREATE_LOCK();
+    IPC_eError_t error = IPC_checkNewHandler( aTaskID );
+    if (error == E_IPC_SUCCESS)
     {
-        return E_IPC_ERR_SEND_FAIL;
+        /* The queue lives in the shared memory before any task of this core can find the handler */
+        IPC_sHandler_t * psHandler  = IPC_addHandler( aTaskID, aHandle, E_IPC_QUEUE_SLOTS );
+        IPC_sMsgQueue_t * psShared  = (IPC_sMsgQueue_t *) apShared;
+        IPC_initQueue( psShared, aQueueLength, aMaxDataLen, apShared + IPC_SHARED_HDR_SIZE );
+        psShared->senderWaiting     = 0;
+        psHandler->apLane[0]        = psShared;
+        psHandler->shared           = 1;
+
+        /* The header goes last, the other core attaches as soon as it sees the queue length */
+        IPC_cacheClean( apShared + IPC_SHARED_HDR_SIZE, IPC_QUEUE_STORAGE_SIZE( aQueueLength, aMaxDataLen ) );
+        IPC_MEMORY_BARRIER();
+        IPC_cacheClean( apShared, IPC_SHARED_HDR_SIZE );
+        IPC_publishHandler( psHandler );
     }
+    IPC_CREATE_UNLOCK();
+
+    return error;
+#else
+    (void) aTaskID;
+    (void) aHandle;
+    (void) aQueueLength;
+    (void) aMaxDataLen;
+    (void) apShared;
+    return E_IPC_ERR_INVALID;
+#endif
 }
 
 /**
- * Receive an IPC message
- * @param   aRecv    Receiver task ID
- * @param   aBuff    Message buffer
- * @return  error
+ * Attach to a handler another core has created by IPC_createSharedHandler()
+ * Called on the sender's core. Afterwards IPC_send() and the other send
+ * functions work with aTaskID like with a local handler.
+ * @param   aTaskID     Receiver task ID, the same as on the receiver's core
+ * @param   apShared    The buffer passed to IPC_createSharedHandler()
+ * @return  error, E_IPC_ERR_NO_HANDLER if the other core hasn't created the handler yet
  */
-IPC_eError_t IPC_receive( IPC_eTaskID_t aRecv, IPC_sMsg_t * apBuf )
+IPC_eError_t IPC_attachSharedHandler( IPC_eTaskID_t aTaskID, uint8_t * apShared )
 {
-    int handlerIdx = IPC_getHandlerIdx( aRecv );
-    if (handlerIdx == -1) // There is no handler for this task ID
+#if (IPC_USE_MULTICORE == 1)
+    if (apShared == NULL || ((uintptr_t) apShared & (IPC_CACHE_LINE_SIZE - 1)) != 0)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if ((uint32_t) aTaskID >= IPC_TASK_ID_CNT)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+
+    IPC_sMsgQueue_t * psShared = (IPC_sMsgQueue_t *) apShared;
+    IPC_cacheInvalidate( psShared, IPC_SHARED_HDR_SIZE );
+    if (psShared->queueLength == 0 || psShared->msgQueue != apShared + IPC_SHARED_HDR_SIZE) // Not created yet
     {
         return E_IPC_ERR_NO_HANDLER;
     }
 
-    IPC_sMsgQueue_t * queue     = &(IPC_arHandler[handlerIdx].queue);
-    if (queue->queueSize == 0)  // Nothing to be received
+    IPC_CREATE_LOCK();
+    IPC_eError_t error = IPC_checkNewHandler( aTaskID );
+    if (error == E_IPC_SUCCESS)
     {
-        return E_IPC_ERR_RECV_FAIL;
+        IPC_sHandler_t * psHandler  = IPC_addHandler( aTaskID, NULL, E_IPC_QUEUE_SLOTS );
+        psHandler->apLane[0]        = psShared;
+        psHandler->shared           = 1;
+        IPC_publishHandler( psHandler );
     }
+    IPC_CREATE_UNLOCK();
 
-    /*
-    * Copy the data from the queue to apBuf.
-    * If you can assure that the receiving task will only use the data for a 
-    * very short amount of time, this line can be replaced by
-    *   *apBuf = queue->msgQueue[queue->queueHead];
-    * This operates even faster, but involves the risk of unwanted behaviour.
-    */
-    memcpy( apBuf, &(queue->msgQueue[queue->queueHead]), sizeof(IPC_sMsg_t));
-    queue->queueSize--;
+    return error;
+#else
+    (void) aTaskID;
+    (void) apShared;
+    return E_IPC_ERR_INVALID;
+#endif
+}
 
-    /*
-    * Increment head pointer - don't use modulo because it might be slower
-    */
-    if (queue->queueHead == IPC_MSG_QUEUE_LENGTH - 1)
+/**
+ * Wake the receiver or the waiting sender of a shared handler
+ * Call it from the interrupt that IPC_REMOTE_NOTIFY() raises. On the receiver's
+ * core it wakes the receiver, on the sender's core the sender that waits for
+ * space.
+ * @param   aTaskID                     Receiver task ID
+ * @param   pxHigherPriorityTaskWoken   Set to pdTRUE if the woken task should run on ISR exit (may be NULL)
+ * @return  error
+ */
+IPC_eError_t IPC_remoteNotifyFromISR( IPC_eTaskID_t aTaskID, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL || (psHandler->handle == NULL && !IPC_IS_SHARED( psHandler ))) // The handler isn't shared with this core
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    if (psHandler->handle == NULL) // Sender's core, the receiver has made space
     {
-        queue->queueHead = 0;
+        BaseType_t xWoken = pdFALSE;
+        IPC_wakeSenders( psHandler, &xWoken );
+        if (pxHigherPriorityTaskWoken != NULL && xWoken != pdFALSE)
+        {
+            *pxHigherPriorityTaskWoken = pdTRUE;
+        }
     }
     else
     {
-        queue->queueHead++;
+        IPC_notifyFromISR( psHandler, pxHigherPriorityTaskWoken );
     }
+    return E_IPC_SUCCESS;
+}
 
-    if (queue->queueSize > 0) // There is more data in the queue to be received
+/**
+ * Set the receiver task of a handler of the static topology
+ * The handlers of IPC_TOPOLOGY exist before their tasks do, so each receiver
+ * has to be bound before it waits for messages. Messages sent before that are
+ * queued without a notification. Only available if IPC_TOPOLOGY is defined.
+ * @param   aTaskID     Receiver task ID
+ * @param   aHandle     Receiver task handle
+ * @return  error
+ */
+IPC_eError_t IPC_bindTask( IPC_eTaskID_t aTaskID, TaskHandle_t aHandle )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
     {
-        return E_IPC_RECV_MORE;
+        return E_IPC_ERR_NO_HANDLER;
     }
-    else  // All data has been received
+#if defined(IPC_TOPOLOGY)
+    if (aHandle == NULL)
     {
-        return E_IPC_SUCCESS;
+        return E_IPC_ERR_INVALID;
     }
+
+    IPC_MEMORY_BARRIER();
+    psHandler->handle = aHandle;
+    return E_IPC_SUCCESS;
+#else
+    (void) aHandle;
+    return E_IPC_ERR_INVALID;
+#endif
 }
 
 /**
- * Get index of the IPC handler
- * @param   taskID    Receiver task ID
- * @return  index
+ * Add a block size to the message pool
+ * Payloads that don't fit into the slots of a handler are stored in a pool
+ * block and its slot only refers to the block, so a handler created with
+ * aMaxDataLen 0 holds nothing but references. The block goes back to the pool
+ * when the message has been received.
+ * @param   aMaxDataLen     The maximum data size of a block (<= IPC_MAX_DATA_LENGTH)
+ * @param   aBlockCnt       Number of blocks (< UINT16_MAX)
+ * @param   apStorage       Pointer aligned buffer of IPC_QUEUE_STORAGE_SIZE( aBlockCnt, aMaxDataLen ) bytes
+ * @return  error
  */
-static int IPC_getHandlerIdx( IPC_eTaskID_t taskID )
+IPC_eError_t IPC_addPoolClass( uint32_t aMaxDataLen, uint32_t aBlockCnt, uint8_t * apStorage )
 {
-    if (IPC_u8HandlerCnt > 0)
+    if (apStorage == NULL || aBlockCnt == 0 || aBlockCnt >= IPC_POOL_IDX_NONE || aMaxDataLen > IPC_MAX_DATA_LENGTH)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (((uintptr_t) apStorage & (sizeof(void *) - 1)) != 0)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (IPC_u8PoolClassCnt == IPC_POOL_CLASS_MAX) // There is no space for more classes
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+
+    /* Keep the classes sorted, so the first that fits is the smallest */
+    uint32_t pos = IPC_u8PoolClassCnt;
+    while (pos > 0 && IPC_arPoolClass[pos - 1].maxDataLen > aMaxDataLen)
+    {
+        IPC_arPoolClass[pos] = IPC_arPoolClass[pos - 1];
+        pos--;
+    }
+
+    IPC_sPoolClass_t * pool = &IPC_arPoolClass[pos];
+    pool->storage           = apStorage;
+    pool->slotSize          = IPC_SLOT_SIZE( aMaxDataLen );
+    pool->maxDataLen        = aMaxDataLen;
+    pool->blockCnt          = aBlockCnt;
+    pool->freeHead          = 0;
+    IPC_u8PoolClassCnt++;
+
+    /* Renumber the classes behind the new one, then link all blocks */
+    for (uint32_t c = pos; c < IPC_u8PoolClassCnt; c++)
     {
-        for (int i = 0; i < IPC_u8HandlerCnt; i++)
+        for (uint32_t i = 0; i < IPC_arPoolClass[c].blockCnt; i++)
         {
-            if (IPC_arHandler[i].recvId == taskID)
+            IPC_sBlockHdr_t * psHdr = IPC_BLOCK_HDR( IPC_BLOCK( &IPC_arPoolClass[c], i ) );
+            psHdr->poolClass        = (uint8_t) c;
+            if (c == pos)
             {
-                return i;
+                psHdr->refCnt       = (i + 1 < aBlockCnt) ? i + 1 : IPC_POOL_IDX_NONE;
+                psHdr->blockIdx     = (uint16_t) i;
             }
         }
     }
-    else
-    {
-        /* empty */
-    }
 
-    return -1;
+    return E_IPC_SUCCESS;
 }
 
-/*******************************************************************************
- * Init function
- ******************************************************************************/
 /**
- * Init IPC Handler module
+ * Send an IPC message
+ * @param   aRecv       Receiver task ID
+ * @param   aType       Message type
+ * @param   apData      Message data
+ * @param   aDataSize   Size of message data in bytes
+ * @return  error
  */
-void IPC_initIPCHandler( void )
+IPC_eError_t IPC_send( IPC_eTaskID_t aRecv, IPC_eMsgType_t aType, uint8_t * apData, int aDataSize )
 {
-    IPC_u8HandlerCnt = 0;
+    if (aDataSize < 0 || aDataSize > IPC_MAX_DATA_LENGTH) // Data cannot be sent because it's too large
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    return IPC_sendTo( psHandler, aType, apData, (uint32_t) aDataSize );
+}
+
+/**
+ * Send an IPC message to a handler of the static topology
+ * Works like IPC_send(), but takes the handler of IPC_TOPOLOGY itself, so
+ * there is no lookup. Use it through IPC_SEND_STATIC().
+ * Only available if IPC_TOPOLOGY is defined.
+ * @param   apHandler   IPC_sTopo_<aTaskID> of the receiver
+ * @param   aType       Message type
+ * @param   apData      Message data
+ * @param   aDataSize   Size of message data in bytes
+ * @return  error
+ */
+IPC_eError_t IPC_sendStatic( struct IPC_sHandler_t * apHandler, IPC_eMsgType_t aType, const uint8_t * apData, uint32_t aDataSize )
+{
+#if defined(IPC_TOPOLOGY)
+    if (aDataSize > IPC_MAX_DATA_LENGTH) // Data cannot be sent because it's too large
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    return IPC_sendTo( apHandler, aType, apData, aDataSize );
+#else
+    (void) apHandler;
+    (void) aType;
+    (void) apData;
+    (void) aDataSize;
+    return E_IPC_ERR_INVALID;
+#endif
+}
+
+/**
+ * Send several IPC messages to the same receiver and notify it once
+ * The messages are queued in order until one of them fails. The receiver gets
+ * a single notification for the whole batch, so it has to drain its queue
+ * (E_IPC_RECV_MORE) instead of counting notifications.
+ * @param   aRecv       Receiver task ID
+ * @param   apMsgs      Array of aCount message descriptors
+ * @param   aCount      Number of messages
+ * @param   apSent      Returns the number of queued messages (may be NULL)
+ * @return  error of the first message that could not be sent, else E_IPC_SUCCESS
+ */
+IPC_eError_t IPC_sendBatch( IPC_eTaskID_t aRecv, const IPC_sBatchMsg_t * apMsgs, uint32_t aCount, uint32_t * apSent )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (apSent != NULL)
+    {
+        *apSent = 0;
+    }
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (IPC_isTailReserved( psHandler )) // The next slot is reserved by IPC_sendReserve()
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_eError_t error  = E_IPC_SUCCESS;
+    uint32_t sent       = 0;
+    while (sent < aCount)
+    {
+        const IPC_sBatchMsg_t * psDesc = &apMsgs[sent];
+        IPC_sMsg_t * psMsg;
+
+        if (psDesc->u32DataLen > IPC_MAX_DATA_LENGTH) // Data cannot be sent because it's too large
+        {
+            error = E_IPC_ERR_SEND_FAIL;
+            break;
+        }
+        error = IPC_queueReserveWait( psHandler, psDesc->eIPC_MsgType, psDesc->u32DataLen, &psMsg );
+        if (error != E_IPC_SUCCESS) // Queue is full
+        {
+            break;
+        }
+
+        IPC_COPY( IPC_queueData( psHandler, psMsg )->u8Data, psDesc->pu8Data, psDesc->u32DataLen );
+        IPC_queueCommit( psHandler, psMsg );
+        sent++;
+    }
+
+    if (apSent != NULL)
+    {
+        *apSent = sent;
+    }
+    if (sent > 0)
+    {
+        IPC_eError_t notifyError = IPC_notify( psHandler );
+        if (error == E_IPC_SUCCESS)
+        {
+            error = notifyError;
+        }
+    }
+    return error;
+}
+
+/**
+ * Send an IPC message without notifying the receiver
+ * The message is visible to the receiver right away, but it is only woken up
+ * by the next IPC_flush(). Use it to coalesce the notifications of a burst.
+ * The receiver gets one notification for all deferred messages.
+ * @param   aRecv       Receiver task ID
+ * @param   aType       Message type
+ * @param   apData      Message data
+ * @param   aDataSize   Size of message data in bytes
+ * @return  error
+ */
+IPC_eError_t IPC_sendDeferred( IPC_eTaskID_t aRecv, IPC_eMsgType_t aType, const uint8_t * apData, uint32_t aDataSize )
+{
+    if (aDataSize > IPC_MAX_DATA_LENGTH) // Data cannot be sent because it's too large
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    IPC_sMsg_t * psMsg;
+    if (IPC_isTailReserved( psHandler )) // The next slot is reserved by IPC_sendReserve()
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+    IPC_eError_t error = IPC_queueReserveWait( psHandler, aType, aDataSize, &psMsg );
+    if (error != E_IPC_SUCCESS) // Queue is full or data too large
+    {
+        return error;
+    }
+
+    IPC_COPY( IPC_queueData( psHandler, psMsg )->u8Data, apData, aDataSize );
+    IPC_queueCommit( psHandler, psMsg );
+
+    psHandler->notifyPending = 1;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Notify the receiver about messages sent by IPC_sendDeferred()
+ * Gives a single notification however many messages are pending, does nothing
+ * if none is.
+ * @param   aRecv       Receiver task ID
+ * @return  error
+ */
+IPC_eError_t IPC_flush( IPC_eTaskID_t aRecv )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (!psHandler->notifyPending)
+    {
+        return E_IPC_SUCCESS;
+    }
+
+    psHandler->notifyPending = 0;
+    return IPC_notify( psHandler );
+}
+
+/**
+ * Reserve the next free slot of the receiver's queue
+ * The payload can be written directly to the returned buffer. The message is
+ * not visible to the receiver until IPC_sendCommit() is called. There can be
+ * max. one open reservation per receiver.
+ * @param   aRecv       Receiver task ID
+ * @param   aType       Message type
+ * @param   aDataSize   Size of message data in bytes
+ * @param   appData     Returns a pointer to the payload buffer inside the queue
+ * @return  error
+ */
+IPC_eError_t IPC_sendReserve( IPC_eTaskID_t aRecv, IPC_eMsgType_t aType, uint32_t aDataSize, uint8_t ** appData )
+{
+    if (aDataSize > IPC_MAX_DATA_LENGTH) // Data cannot be sent because it's too large
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    IPC_sMsg_t * psMsg;
+    if (!IPC_ATOMIC_CAS( &(psHandler->reserved), 0, 1 )) // There already is an open reservation
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+    IPC_eError_t error = IPC_queueReserveWait( psHandler, aType, aDataSize, &psMsg );
+    if (error != E_IPC_SUCCESS) // Queue is full or data too large
+    {
+        psHandler->reserved = 0;
+        return error;
+    }
+
+    psHandler->reservedMsg  = psMsg;
+    *appData                = IPC_queueData( psHandler, psMsg )->u8Data;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Publish the slot reserved by IPC_sendReserve() and notify the receiver
+ * @param   aRecv       Receiver task ID
+ * @return  error
+ */
+IPC_eError_t IPC_sendCommit( IPC_eTaskID_t aRecv )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    if (!psHandler->reserved) // Nothing to be committed
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_DMA_DONE( psHandler );
+    IPC_queueCommit( psHandler, psHandler->reservedMsg );
+    psHandler->reserved = 0;
+    return IPC_notify( psHandler );
+}
+
+/**
+ * Send an IPC message from an interrupt service routine
+ * Works like IPC_send(), but notifies the receiver with vTaskNotifyGiveIndexedFromISR().
+ * Unless the receiver's queue is in E_IPC_QUEUE_MODE_MPSC, don't send to the
+ * same receiver from an ISR and from a task.
+ * @param   aRecv                       Receiver task ID
+ * @param   aType                       Message type
+ * @param   apData                      Message data
+ * @param   aDataSize                   Size of message data in bytes
+ * @param   pxHigherPriorityTaskWoken   Set to pdTRUE if the receiver should run on ISR exit (may be NULL)
+ * @return  error
+ */
+IPC_eError_t IPC_sendFromISR( IPC_eTaskID_t aRecv, IPC_eMsgType_t aType, const uint8_t * apData, uint32_t aDataSize,
+                              BaseType_t * pxHigherPriorityTaskWoken )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    IPC_sMsg_t * psMsg;
+    if (IPC_isTailReserved( psHandler ) || aDataSize > IPC_MAX_DATA_LENGTH) // Slot is reserved or data too large
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+    IPC_eError_t error = IPC_queueReserve( psHandler, aType, aDataSize, &psMsg );    // ISRs never block
+    if (error != E_IPC_SUCCESS) // Queue is full or data too large
+    {
+        if (error == E_IPC_ERR_QUEUE_FULL)
+        {
+            IPC_STATS_ADD( psHandler->stats.rejected );
+        }
+        return error;
+    }
+
+    IPC_COPY( IPC_queueData( psHandler, psMsg )->u8Data, apData, aDataSize );
+
+    IPC_queueCommit( psHandler, psMsg );
+    IPC_notifyFromISR( psHandler, pxHigherPriorityTaskWoken );
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Publish the slot reserved by IPC_sendReserve() from an interrupt service routine
+ * Lets a DMA completion interrupt hand over a buffer that was filled in place,
+ * including the transfers IPC_send() started (see IPC_setDmaThreshold()).
+ * @param   aRecv                       Receiver task ID
+ * @param   pxHigherPriorityTaskWoken   Set to pdTRUE if the receiver should run on ISR exit (may be NULL)
+ * @return  error
+ */
+IPC_eError_t IPC_sendCommitFromISR( IPC_eTaskID_t aRecv, BaseType_t * pxHigherPriorityTaskWoken )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (!psHandler->reserved) // Nothing to be committed
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_DMA_DONE( psHandler );
+    IPC_queueCommit( psHandler, psHandler->reservedMsg );
+    psHandler->reserved = 0;
+    IPC_notifyFromISR( psHandler, pxHigherPriorityTaskWoken );
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Select how the queue of a handler is shared between senders
+ * @param   aTaskID     Receiver task ID
+ * @param   aMode       E_IPC_QUEUE_MODE_SPSC or E_IPC_QUEUE_MODE_MPSC
+ * @return  error
+ */
+IPC_eError_t IPC_setQueueMode( IPC_eTaskID_t aTaskID, IPC_eQueueMode_t aMode )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (psHandler->kind != E_IPC_QUEUE_SLOTS || IPC_IS_SHARED( psHandler )) // Only local slot queues support several senders
+    {
+        return E_IPC_ERR_INVALID;
+    }
+    if (IPC_slotCount( psHandler ) > 0 || psHandler->reserved) // Queue is in use
+    {
+        return E_IPC_ERR_INVALID;
+    }
+    if (aMode == E_IPC_QUEUE_MODE_MPSC && psHandler->policy == E_IPC_OVERFLOW_OVERWRITE) // Only one sender may drop messages
+    {
+        return E_IPC_ERR_INVALID;
+    }
+#if (IPC_USE_DMA == 1)
+    if (aMode != E_IPC_QUEUE_MODE_MPSC && psHandler->dmaThreshold != 0) // IPC_setDmaThreshold() relies on claimed slots
+    {
+        return E_IPC_ERR_INVALID;
+    }
+#endif
+
+    for (uint32_t l = 0; l < IPC_LANE_CNT; l++)
+    {
+        IPC_LANE( psHandler, l )->multiProducer = (aMode == E_IPC_QUEUE_MODE_MPSC);
+    }
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Select what happens if a message is sent to a full queue
+ * @param   aTaskID         Receiver task ID
+ * @param   aPolicy         Overflow policy
+ * @param   xTicksToWait    Max. time IPC_send() waits for space (E_IPC_OVERFLOW_BLOCK only)
+ * @return  error
+ */
+IPC_eError_t IPC_setOverflowPolicy( IPC_eTaskID_t aTaskID, IPC_eOverflowPolicy_t aPolicy, TickType_t xTicksToWait )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (aPolicy == E_IPC_OVERFLOW_OVERWRITE
+        && (psHandler->kind != E_IPC_QUEUE_SLOTS || IPC_LANE( psHandler, 0 )->multiProducer || IPC_IS_SHARED( psHandler )))
+    {
+        return E_IPC_ERR_INVALID;   // Dropping is only supported for local slot queues with a single sender
+    }
+
+    psHandler->policy       = aPolicy;
+    psHandler->blockTicks   = xTicksToWait;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Get the credits of a sender, the space left in the queue of a message type
+ * Every message the receiver takes out of the queue gives a credit back. The
+ * count is taken from the queue indices without a kernel call, so it can be
+ * checked before every send. Not supported by mailbox handlers, which are
+ * never full.
+ * @param   aRecv       Receiver task ID
+ * @param   aType       Message type, selects the lane
+ * @param   apCredits   Returns the number of free slots, for byte ring handlers
+ *                      the largest IPC_RING_RECORD_SIZE() that fits
+ * @return  error
+ */
+IPC_eError_t IPC_getCredits( IPC_eTaskID_t aRecv, IPC_eMsgType_t aType, uint32_t * apCredits )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (psHandler->kind == E_IPC_QUEUE_MAILBOX) // A mailbox is never full
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    *apCredits = IPC_credits( psHandler, aType );
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Wait until the queue of a message type has at least aCredits credits
+ * The receiver wakes the sender on IPC_WAIT_NOTIFY_INDEX as soon as it has
+ * released enough messages. If more than IPC_WAITER_MAX senders wait at once,
+ * the others check the credits once per tick. So does every sender if the
+ * kernel has a single notification index, which all handlers use. Must be
+ * called by a task.
+ * @param   aRecv           Receiver task ID
+ * @param   aType           Message type, selects the lane
+ * @param   aCredits        Number of credits to wait for (see IPC_getCredits())
+ * @param   xTicksToWait    Max. time to wait
+ * @return  error, E_IPC_ERR_QUEUE_FULL if the credits didn't come back in time
+ */
+IPC_eError_t IPC_waitCredits( IPC_eTaskID_t aRecv, IPC_eMsgType_t aType, uint32_t aCredits, TickType_t xTicksToWait )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (psHandler->kind == E_IPC_QUEUE_MAILBOX) // A mailbox is never full
+    {
+        return E_IPC_ERR_INVALID;
+    }
+    uint32_t max = (psHandler->kind == E_IPC_QUEUE_RING) ? psHandler->ring.ringSize - 1
+                                                          : IPC_typeQueue( psHandler, aType )->queueLength;
+    if (aCredits > max) // The queue never has that many
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    return IPC_spaceWait( psHandler, aType, aCredits, 0, xTicksToWait );
+}
+
+/**
+ * Let IPC_send() copy large payloads to this handler by DMA
+ * IPC_send() reserves the slot, starts IPC_DMA_START() and returns without
+ * waiting for the copy. The transfer's completion interrupt publishes the
+ * message with IPC_sendCommitFromISR(). Until then apData must not change.
+ * Sends during a transfer take the next slot and copy by CPU, the receiver
+ * still gets the messages in order. Needs E_IPC_QUEUE_MODE_MPSC, and every
+ * lane and pool class must start on a cache line, so add them first.
+ * Only available if IPC_USE_DMA is 1.
+ * @param   aTaskID     Receiver task ID
+ * @param   aThreshold  Min. payload size in bytes IPC_send() copies by DMA, 0 to always copy by CPU
+ * @return  error, E_IPC_ERR_INVALID if the queue isn't MPSC or not cache line aligned
+ */
+IPC_eError_t IPC_setDmaThreshold( IPC_eTaskID_t aTaskID, uint32_t aThreshold )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+#if (IPC_USE_DMA == 1)
+    if (aThreshold != 0)
+    {
+        if (psHandler->kind != E_IPC_QUEUE_SLOTS || !IPC_LANE( psHandler, 0 )->multiProducer) // Other sends need their own slot during a transfer
+        {
+            return E_IPC_ERR_INVALID;
+        }
+        else if (!IPC_dmaAligned( psHandler )) // The invalidate after a transfer would drop lines of other slots
+        {
+            return E_IPC_ERR_INVALID;
+        }
+    }
+    psHandler->dmaThreshold = aThreshold;
+    return E_IPC_SUCCESS;
+#else
+    (void) aThreshold;
+    return E_IPC_ERR_INVALID;
+#endif
+}
+
+/**
+ * Select the task notification index a handler notifies its receiver on
+ * Keeps IPC notifications apart from those the task uses for other events, i.e.
+ * DMA or timers. The default is IPC_NOTIFY_INDEX (0).
+ * @param   aTaskID     Receiver task ID
+ * @param   uxIndex     Notification index (< configTASK_NOTIFICATION_ARRAY_ENTRIES, not IPC_WAIT_NOTIFY_INDEX)
+ * @return  error
+ */
+IPC_eError_t IPC_setNotifyIndex( IPC_eTaskID_t aTaskID, UBaseType_t uxIndex )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (uxIndex >= IPC_NOTIFY_INDEX_CNT) // The kernel doesn't have this index
+    {
+        return E_IPC_ERR_INVALID;
+    }
+    if (IPC_NOTIFY_INDEX_CNT > 1 && uxIndex == IPC_WAIT_NOTIFY_INDEX) // Reserved for tasks waiting for space or in IPC_call()
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    psHandler->notifyIndex = uxIndex;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Add a handler to the select group of its receiver task
+ * A task can own several handlers (one per task ID) and wait for all of them
+ * with IPC_select(). The handler then notifies the task by setting its select
+ * bit instead of incrementing the notification count. All handlers of a task's
+ * select group must use the same notification index, which should not be used
+ * for anything else.
+ * @param   aTaskID     Receiver task ID
+ * @param   aBit        Select bit of the handler (0 .. 31)
+ * @return  error
+ */
+IPC_eError_t IPC_setSelectBit( IPC_eTaskID_t aTaskID, uint32_t aBit )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (aBit >= 32)
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    psHandler->notifyBits = 1UL << aBit;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Wait until at least one handler of the calling task's select group has a message
+ * The queues are checked first, so there is no kernel call if a message is
+ * already waiting. A set bit only means the handler has a message at the time
+ * of the check, receive until the handler is empty before selecting again.
+ * @param   aBits           Select bits of the handlers to wait for
+ * @param   apReady         Returns the select bits of the handlers with messages
+ * @param   xTicksToWait    Max. time to wait for a message
+ * @return  error, E_IPC_ERR_RECV_FAIL if no message arrived in time
+ */
+IPC_eError_t IPC_select( uint32_t aBits, uint32_t * apReady, TickType_t xTicksToWait )
+{
+    IPC_sHandler_t * psHandler;
+    TaskHandle_t xSelf  = xTaskGetCurrentTaskHandle();
+    uint32_t ready      = IPC_selectReady( xSelf, aBits, &psHandler );
+
+    *apReady = ready;
+    if (psHandler == NULL) // None of the bits belongs to a handler of this task
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (ready != 0)
+    {
+        return E_IPC_SUCCESS;
+    }
+
+    TimeOut_t xTimeOut;
+    vTaskSetTimeOutState( &xTimeOut );
+    do
+    {
+        /* Bits set after the check above are still pending, so the wait returns right away */
+        if (IPC_NOTIFY_WAIT( psHandler, xTicksToWait ) == pdFALSE)  // Timed out
+        {
+            break;
+        }
+        ready = IPC_selectReady( xSelf, aBits, &psHandler );
+    } while (ready == 0 && xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE);
+
+    *apReady = ready;
+    return (ready != 0) ? E_IPC_SUCCESS : E_IPC_ERR_RECV_FAIL;
+}
+
+/**
+ * Add a priority lane to a handler
+ * The messages of a lane are received before those of all lower lanes. Lane 0
+ * is the queue the handler has been created with.
+ * @param   aTaskID         Receiver task ID
+ * @param   aLane           Lane number (1 .. IPC_LANE_CNT - 1)
+ * @param   aQueueLength    Number of messages the lane can hold
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apStorage       Pointer aligned buffer of IPC_QUEUE_STORAGE_SIZE( aQueueLength, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_addLane( IPC_eTaskID_t aTaskID, uint32_t aLane, uint32_t aQueueLength, uint32_t aMaxDataLen,
+                          uint8_t * apStorage )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (psHandler->kind != E_IPC_QUEUE_SLOTS || IPC_IS_SHARED( psHandler ) || aLane == 0 || aLane >= IPC_LANE_CNT)
+    {
+        return E_IPC_ERR_INVALID;
+    }
+    if (apStorage == NULL || aQueueLength == 0 || aMaxDataLen > IPC_MAX_DATA_LENGTH)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (((uintptr_t) apStorage & (sizeof(void *) - 1)) != 0)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (IPC_LANE( psHandler, aLane )->queueLength != 0) // The lane already exists
+    {
+        return E_IPC_ERR_EXISTS;
+    }
+
+    IPC_initQueue( IPC_LANE( psHandler, aLane ), aQueueLength, aMaxDataLen, apStorage );
+    IPC_LANE( psHandler, aLane )->multiProducer = IPC_LANE( psHandler, 0 )->multiProducer;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Select the lane messages of a type are sent to
+ * All types are sent to lane 0 by default.
+ * @param   aTaskID     Receiver task ID
+ * @param   aType       Message type
+ * @param   aLane       Lane number, the lane must have been added by IPC_addLane()
+ * @return  error
+ */
+IPC_eError_t IPC_setTypeLane( IPC_eTaskID_t aTaskID, IPC_eMsgType_t aType, uint32_t aLane )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if ((uint32_t) aType >= E_IPC_MSG_TYPE_CNT || aLane >= IPC_LANE_CNT || IPC_LANE( psHandler, aLane )->queueLength == 0)
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    psHandler->typeLane[aType] = (uint8_t) aLane;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Create a topic with caller provided storage for its messages
+ * A published message is stored once in the topic's pool and stays there until
+ * every subscriber has received or released it.
+ * @param   aTopic          Topic ID
+ * @param   aPoolLength     Number of messages that can be in flight at the same time
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apStorage       Pointer aligned buffer of IPC_QUEUE_STORAGE_SIZE( aPoolLength, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_createTopic( IPC_eTopicID_t aTopic, uint32_t aPoolLength, uint32_t aMaxDataLen, uint8_t * apStorage )
+{
+    if ((uint32_t) aTopic >= E_IPC_TOPIC_CNT || apStorage == NULL || aPoolLength == 0 || aMaxDataLen > IPC_MAX_DATA_LENGTH)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (((uintptr_t) apStorage & (sizeof(void *) - 1)) != 0)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (IPC_arTopic[aTopic].pool != NULL) // The topic already exists
+    {
+        return E_IPC_ERR_EXISTS;
+    }
+
+    IPC_sTopic_t * psTopic  = &IPC_arTopic[aTopic];
+    psTopic->slotSize       = IPC_SLOT_SIZE( aMaxDataLen );
+    psTopic->maxDataLen     = aMaxDataLen;
+    psTopic->poolLength     = aPoolLength;
+    psTopic->nextFree       = 0;
+    psTopic->subCnt         = 0;
+
+    for (uint32_t i = 0; i < aPoolLength; i++)
+    {
+        IPC_sBlockHdr_t * psHdr = (IPC_sBlockHdr_t *) &apStorage[i * psTopic->slotSize];
+        psHdr->refCnt       = 0;
+        psHdr->poolClass    = IPC_POOL_NONE;
+    }
+    psTopic->pool           = apStorage;
+
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Subscribe the handler of a task to a topic
+ * Only slot queue handlers can subscribe. The publisher counts as a sender to
+ * the subscriber's queue, so use E_IPC_QUEUE_MODE_MPSC if the subscriber
+ * receives from other senders as well.
+ * @param   aTopic      Topic ID
+ * @param   aTaskID     Subscriber task ID
+ * @return  error
+ */
+IPC_eError_t IPC_subscribe( IPC_eTopicID_t aTopic, IPC_eTaskID_t aTaskID )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if ((uint32_t) aTopic >= E_IPC_TOPIC_CNT || IPC_arTopic[aTopic].pool == NULL) // There is no such topic
+    {
+        return E_IPC_ERR_INVALID;
+    }
+    if (psHandler->kind != E_IPC_QUEUE_SLOTS || IPC_IS_SHARED( psHandler )) // Only local slots can hold a reference
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    IPC_sTopic_t * psTopic  = &IPC_arTopic[aTopic];
+    IPC_eError_t error      = E_IPC_SUCCESS;
+    IPC_CREATE_LOCK();
+    for (uint32_t i = 0; i < psTopic->subCnt; i++)
+    {
+        if (psTopic->apSub[i] == psHandler) // Already subscribed
+        {
+            error = E_IPC_ERR_EXISTS;
+        }
+    }
+    if (error == E_IPC_SUCCESS && psTopic->subCnt == IPC_TOPIC_SUB_MAX) // There is no space for more subscribers
+    {
+        error = E_IPC_ERR_INVALID;
+    }
+    if (error == E_IPC_SUCCESS)
+    {
+        psTopic->apSub[psTopic->subCnt] = psHandler;
+        IPC_MEMORY_BARRIER(); // The publisher never counts an entry before it is written
+        psTopic->subCnt++;
+    }
+    IPC_CREATE_UNLOCK();
+
+    return error;
+}
+
+/**
+ * Publish an IPC message to all subscribers of a topic
+ * The payload is copied once, each subscriber's queue only gets a reference.
+ * Subscribers receive it like any other message. A subscriber with a full queue
+ * misses the message, the others still get it. Only one task may publish to a
+ * topic.
+ * @param   aTopic      Topic ID
+ * @param   aType       Message type
+ * @param   apData      Message data
+ * @param   aDataSize   Size of message data in bytes
+ * @return  error, E_IPC_ERR_QUEUE_FULL if the pool or a subscriber's queue was full
+ */
+IPC_eError_t IPC_publish( IPC_eTopicID_t aTopic, IPC_eMsgType_t aType, const uint8_t * apData, uint32_t aDataSize )
+{
+    if ((uint32_t) aTopic >= E_IPC_TOPIC_CNT || IPC_arTopic[aTopic].pool == NULL) // There is no such topic
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    IPC_sTopic_t * psTopic  = &IPC_arTopic[aTopic];
+    if (aDataSize > psTopic->maxDataLen) // Data cannot be sent because it's too large
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    /* Find a pool entry that isn't referenced by any subscriber queue */
+    IPC_sMsg_t * psMsg  = NULL;
+    uint32_t idx        = psTopic->nextFree;
+    for (uint32_t i = 0; i < psTopic->poolLength && psMsg == NULL; i++)
+    {
+        IPC_sBlockHdr_t * psHdr = (IPC_sBlockHdr_t *) &(psTopic->pool[idx * psTopic->slotSize]);
+        if (psHdr->refCnt == 0)
+        {
+            psMsg = (IPC_sMsg_t *) ((uint8_t *) psHdr + IPC_SLOT_HDR_SIZE);
+        }
+        idx = (idx == psTopic->poolLength - 1) ? 0 : idx + 1;
+    }
+    if (psMsg == NULL) // All messages are still referenced
+    {
+        return E_IPC_ERR_QUEUE_FULL;
+    }
+    psTopic->nextFree = idx;
+
+    IPC_MEMORY_BARRIER(); // The last subscriber is done with the entry before it is written
+    psMsg->eIPC_MsgType = aType;
+    psMsg->u32DataLen   = aDataSize;
+#if (IPC_USE_RPC == 1)
+    psMsg->u32CallID    = 0;
+#endif
+    IPC_COPY( psMsg->u8Data, apData, aDataSize );
+#if (IPC_USE_STATS == 1)
+    psMsg->u32Timestamp = IPC_GET_TIMESTAMP();  // Once for all subscribers, the commits don't touch a shared block
+#endif
+
+    /*
+    * The publisher holds one reference until all subscribers got theirs, so a
+    * fast subscriber can't free the entry while it is still being handed out.
+    */
+    IPC_BLOCK_HDR( psMsg )->refCnt = psTopic->subCnt + 1;
+
+    IPC_eError_t error  = E_IPC_SUCCESS;
+    uint32_t unref      = 1;
+    for (uint32_t i = 0; i < psTopic->subCnt; i++)
+    {
+        IPC_sHandler_t * psHandler = psTopic->apSub[i];
+        IPC_sMsg_t * psSlot;
+
+        if (IPC_isTailReserved( psHandler ) || IPC_queueReserve( psHandler, aType, 0, &psSlot ) != E_IPC_SUCCESS)
+        {
+            error = E_IPC_ERR_QUEUE_FULL;   // This subscriber misses the message
+            unref++;
+            IPC_STATS_ADD( psHandler->stats.rejected );
+            continue;
+        }
+
+        IPC_SLOT_HDR( psSlot )->ref = psMsg;
+        IPC_queueCommit( psHandler, psSlot );
+        if (IPC_notify( psHandler ) != E_IPC_SUCCESS && error == E_IPC_SUCCESS)
+        {
+            error = E_IPC_ERR_SEND_FAIL;
+        }
+    }
+
+    IPC_blockUnref( psMsg, unref );
+    return error;
+}
+
+/**
+ * Receive an IPC message
+ * @param   aRecv    Receiver task ID
+ * @param   aBuff    Message buffer
+ * @return  error
+ */
+IPC_eError_t IPC_receive( IPC_eTaskID_t aRecv, IPC_sMsg_t * apBuf )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    IPC_sMsg_t * psMsg;
+    if (IPC_queuePeek( psHandler, &psMsg ) == E_IPC_ERR_RECV_FAIL)  // Nothing to be received
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    /*
+    * Copy the header and only the used part of the payload to apBuf.
+    * If you don't need a private copy, IPC_receivePeek() avoids the copy
+    * altogether.
+    */
+    apBuf->eIPC_MsgType = psMsg->eIPC_MsgType;
+    apBuf->u32DataLen   = psMsg->u32DataLen;
+#if (IPC_USE_STATS == 1)
+    apBuf->u32Timestamp = psMsg->u32Timestamp;
+#endif
+#if (IPC_USE_RPC == 1)
+    apBuf->u32CallID    = psMsg->u32CallID;
+#endif
+    IPC_COPY( apBuf->u8Data, psMsg->u8Data, psMsg->u32DataLen );
+
+    return IPC_queueRelease( psHandler );
+}
+
+/**
+ * Receive an IPC message, wait for one if the queue is empty
+ * If a message is waiting, it is received without a kernel call. Otherwise the
+ * receiver task blocks on its notification until a message arrives or the
+ * timeout expires. Notifications of messages that have already been received
+ * only cause another check of the queue. Must only be called by the receiver
+ * task.
+ * @param   aRecv           Receiver task ID
+ * @param   apBuf           Message buffer
+ * @param   xTicksToWait    Max. time to wait for a message
+ * @return  error, E_IPC_ERR_RECV_FAIL if no message arrived in time
+ */
+IPC_eError_t IPC_receiveWait( IPC_eTaskID_t aRecv, IPC_sMsg_t * apBuf, TickType_t xTicksToWait )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    IPC_eError_t error = IPC_receive( aRecv, apBuf );
+    if (error != E_IPC_ERR_RECV_FAIL)   // Got a message
+    {
+        return error;
+    }
+
+    TimeOut_t xTimeOut;
+    vTaskSetTimeOutState( &xTimeOut );
+    do
+    {
+        /*
+        * The count is cleared, since the queue is checked after every wakeup.
+        * A message sent in between has already given a new notification.
+        */
+        if (IPC_NOTIFY_TAKE( psHandler, pdTRUE, xTicksToWait ) == 0)  // Timed out
+        {
+            break;
+        }
+        error = IPC_receive( aRecv, apBuf );
+    } while (error == E_IPC_ERR_RECV_FAIL && xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE);
+
+    return error;
+}
+
+/**
+ * Borrow the oldest IPC message without copying it
+ * The returned slot stays valid and will not be overwritten by IPC_send() until
+ * it is handed back by IPC_receiveRelease(). Only one message can be borrowed
+ * per handler at a time. Don't access the payload beyond u32DataLen.
+ * @param   aRecv       Receiver task ID
+ * @param   appMsg      Returns a pointer to the message inside the queue
+ * @return  error
+ */
+IPC_eError_t IPC_receivePeek( IPC_eTaskID_t aRecv, const IPC_sMsg_t ** appMsg )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    /*
+    * The head slot is only handed out. It counts as occupied until
+    * IPC_receiveRelease() is called, so IPC_send() cannot reuse it.
+    */
+    IPC_sMsg_t * psMsg;
+    IPC_eError_t error = IPC_queuePeek( psHandler, &psMsg );
+    if (error != E_IPC_ERR_RECV_FAIL)
+    {
+        *appMsg = psMsg;
+    }
+
+    return error;
+}
+
+/**
+ * Release the message borrowed by IPC_receivePeek()
+ * @param   aRecv       Receiver task ID
+ * @return  error
+ */
+IPC_eError_t IPC_receiveRelease( IPC_eTaskID_t aRecv )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    IPC_sMsg_t * psMsg;
+    if (IPC_queuePeekLane( psHandler, &psMsg ) == E_IPC_ERR_RECV_FAIL)  // Nothing has been borrowed
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    return IPC_queueRelease( psHandler );
+}
+
+/**
+ * Forward the oldest message of a handler to another task
+ * Receives the message from aRecvFrom and sends it to aSendTo as aType. A
+ * message that is stored in a pool or topic block is handed over by reference,
+ * so the payload isn't copied. It is copied once if it is stored in the slot
+ * itself, if the block is shared with other receivers and the type changes or
+ * if aSendTo is a byte ring handler. If it can't be sent, the message stays in
+ * aRecvFrom's queue.
+ * @param   aRecvFrom   Task ID of the handler to take the message from
+ * @param   aSendTo     Receiver task ID
+ * @param   aType       Message type of the forwarded message
+ * @return  error, E_IPC_RECV_MORE if there are more messages for aRecvFrom
+ */
+IPC_eError_t IPC_forward( IPC_eTaskID_t aRecvFrom, IPC_eTaskID_t aSendTo, IPC_eMsgType_t aType )
+{
+    IPC_sHandler_t * psSrc  = IPC_getHandler( aRecvFrom );
+    IPC_sHandler_t * psDst  = IPC_getHandler( aSendTo );
+    if (psSrc == NULL || psDst == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (psSrc == psDst)
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    IPC_sMsg_t * psMsg;
+    if (IPC_queuePeek( psSrc, &psMsg ) == E_IPC_ERR_RECV_FAIL)  // Nothing to be forwarded
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+    if (IPC_isTailReserved( psDst )) // The next slot is reserved by IPC_sendReserve()
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_sSlotHdr_t * psSrcHdr = NULL;
+    if (psSrc->kind == E_IPC_QUEUE_SLOTS)
+    {
+        IPC_sMsgQueue_t * queue = IPC_LANE( psSrc, psSrc->recvLane );
+        psSrcHdr = IPC_SLOT_HDR( IPC_SLOT( queue, queue->queueHead ) );
+    }
+
+    IPC_sMsg_t * psDstMsg;
+    IPC_eError_t error;
+    if (psSrcHdr != NULL && psSrcHdr->ref != NULL && psDst->kind == E_IPC_QUEUE_SLOTS && !IPC_IS_SHARED( psDst )
+        && (psMsg->eIPC_MsgType == aType || IPC_BLOCK_HDR( psMsg )->refCnt == 1))
+    {
+        /* Move the reference, the block's count doesn't change */
+        error = IPC_queueReserve( psDst, aType, 0, &psDstMsg );
+        if (error != E_IPC_SUCCESS)
+        {
+            if (error == E_IPC_ERR_QUEUE_FULL)
+            {
+                IPC_STATS_ADD( psDst->stats.rejected );
+            }
+            return error;
+        }
+#if (IPC_USE_STATS == 1)
+        /* The source slot is released without its reference, it keeps the send time for the latency */
+        ((IPC_sMsg_t *) ((uint8_t *) psSrcHdr + IPC_SLOT_HDR_SIZE))->u32Timestamp = psMsg->u32Timestamp;
+#endif
+        psMsg->eIPC_MsgType             = aType;
+        IPC_SLOT_HDR( psDstMsg )->ref   = psMsg;
+        psSrcHdr->ref                   = NULL;
+    }
+    else
+    {
+        error = IPC_queueReserveWait( psDst, aType, psMsg->u32DataLen, &psDstMsg );
+        if (error != E_IPC_SUCCESS)
+        {
+            return error;
+        }
+        IPC_COPY( IPC_queueData( psDst, psDstMsg )->u8Data, psMsg->u8Data, psMsg->u32DataLen );
+#if (IPC_USE_RPC == 1)
+        IPC_queueData( psDst, psDstMsg )->u32CallID = psMsg->u32CallID;   // The task it is forwarded to can reply
+#endif
+    }
+
+    IPC_queueCommit( psDst, psDstMsg );
+    IPC_eError_t recvError = IPC_queueRelease( psSrc );
+
+    error = IPC_notify( psDst );
+    return (error == E_IPC_SUCCESS) ? recvError : error;
+}
+
+/**
+ * Receive up to aMaxCount IPC messages in one call
+ * Drains the queue in one pass and hands the slots back at once. At most
+ * IPC_BATCH_MAX messages are received per call.
+ * @param   aRecv       Receiver task ID
+ * @param   apBufs      Array of aMaxCount message buffers
+ * @param   aMaxCount   Max. number of messages to receive
+ * @param   apReceived  Returns the number of received messages
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE if messages are left or E_IPC_ERR_RECV_FAIL if there was none
+ */
+IPC_eError_t IPC_receiveBatch( IPC_eTaskID_t aRecv, IPC_sMsg_t * apBufs, uint32_t aMaxCount, uint32_t * apReceived )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    IPC_sMsg_t * apsMsg[IPC_BATCH_MAX];
+    uint32_t count = IPC_queuePeekBatch( psHandler, apsMsg, (aMaxCount < IPC_BATCH_MAX) ? aMaxCount : IPC_BATCH_MAX );
+
+    *apReceived = count;
+    if (count == 0)  // Nothing to be received
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        apBufs[i].eIPC_MsgType  = apsMsg[i]->eIPC_MsgType;
+        apBufs[i].u32DataLen    = apsMsg[i]->u32DataLen;
+#if (IPC_USE_STATS == 1)
+        apBufs[i].u32Timestamp  = apsMsg[i]->u32Timestamp;
+#endif
+#if (IPC_USE_RPC == 1)
+        apBufs[i].u32CallID     = apsMsg[i]->u32CallID;
+#endif
+        IPC_COPY( apBufs[i].u8Data, apsMsg[i]->u8Data, apsMsg[i]->u32DataLen );
+    }
+
+    return IPC_queueReleaseBatch( psHandler, count );
+}
+
+/**
+ * Borrow up to aMaxCount IPC messages without copying them
+ * Works like IPC_receivePeek() for several messages. The pointers refer to
+ * consecutive messages of the queue, the ring wrap is already accounted for.
+ * Hand them back with IPC_receiveReleaseBatch().
+ * @param   aRecv       Receiver task ID
+ * @param   appMsgs     Array of aMaxCount message pointers
+ * @param   aMaxCount   Max. number of messages to borrow
+ * @param   apCount     Returns the number of borrowed messages
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE if messages are left or E_IPC_ERR_RECV_FAIL if there was none
+ */
+IPC_eError_t IPC_receivePeekBatch( IPC_eTaskID_t aRecv, const IPC_sMsg_t ** appMsgs, uint32_t aMaxCount, uint32_t * apCount )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    uint32_t count  = IPC_queuePeekBatch( psHandler, (IPC_sMsg_t **) appMsgs, aMaxCount );
+    *apCount        = count;
+    if (count == 0)  // Nothing to be received
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    return IPC_queueHasMore( psHandler, count ) ? E_IPC_RECV_MORE : E_IPC_SUCCESS;
+}
+
+/**
+ * Release messages borrowed by IPC_receivePeekBatch()
+ * A count larger than the number of messages in the queue is clamped, so
+ * messages a sender is still writing are never released.
+ * @param   aRecv       Receiver task ID
+ * @param   aCount      Number of messages to release (the count returned by IPC_receivePeekBatch())
+ * @return  error
+ */
+IPC_eError_t IPC_receiveReleaseBatch( IPC_eTaskID_t aRecv, uint32_t aCount )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (aCount == 0)
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    return IPC_queueReleaseBatch( psHandler, aCount );
+}
+
+/**
+ * Register the function IPC_dispatch() calls for messages of a type
+ * @param   aTaskID         Receiver task ID
+ * @param   aType           Message type
+ * @param   apfnCallback    Callback, NULL to remove it
+ * @return  error
+ */
+IPC_eError_t IPC_registerCallback( IPC_eTaskID_t aTaskID, IPC_eMsgType_t aType, IPC_pfnCallback_t apfnCallback )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if ((uint32_t) aType >= E_IPC_MSG_TYPE_CNT)
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    psHandler->callback[aType] = apfnCallback;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Receive up to aMaxCount IPC messages and pass each to the callback of its type
+ * The callback gets a pointer to the payload inside the queue, so the message
+ * isn't copied. The payload is only valid until the callback returns. Messages
+ * of a type without a callback are dropped. Must only be called by the
+ * receiver task.
+ * @param   aTaskID     Receiver task ID
+ * @param   aMaxCount   Max. number of messages to dispatch
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE if messages are left or E_IPC_ERR_RECV_FAIL if there was none
+ */
+IPC_eError_t IPC_dispatch( IPC_eTaskID_t aTaskID, uint32_t aMaxCount )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+
+    IPC_eError_t error  = E_IPC_ERR_RECV_FAIL;
+    uint32_t done       = 0;
+    while (done < aMaxCount)
+    {
+        IPC_sMsg_t * apsMsg[IPC_BATCH_MAX];
+        uint32_t count = IPC_queuePeekBatch( psHandler, apsMsg, (aMaxCount - done < IPC_BATCH_MAX) ? aMaxCount - done : IPC_BATCH_MAX );
+        if (count == 0)  // Nothing left to be received
+        {
+            break;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            IPC_eMsgType_t eType = apsMsg[i]->eIPC_MsgType;
+            if ((uint32_t) eType < E_IPC_MSG_TYPE_CNT && psHandler->callback[eType] != NULL)
+            {
+                psHandler->callback[eType]( eType, apsMsg[i]->u8Data, apsMsg[i]->u32DataLen );
+            }
+        }
+
+        error   = IPC_queueReleaseBatch( psHandler, count );
+        done   += count;
+    }
+
+    return error;
+}
+
+/**
+ * Send a request and wait for its reply
+ * The request is queued like by IPC_send() with a call ID in its header. The
+ * receiver answers it with IPC_reply(), which writes the reply directly into
+ * apResp and wakes the caller on IPC_WAIT_NOTIFY_INDEX, so the reply never
+ * goes through a queue and the caller doesn't need a handler of its own. A
+ * reply that comes after the timeout is discarded. Must be called by a task.
+ * Only available if IPC_USE_RPC is 1, which needs at least two notification
+ * indices (configTASK_NOTIFICATION_ARRAY_ENTRIES >= 2).
+ * @param   aRecv           Receiver task ID
+ * @param   aType           Message type of the request
+ * @param   apReq           Request data
+ * @param   aReqSize        Size of request data in bytes
+ * @param   apResp          Returns the reply
+ * @param   xTicksToWait    Max. time to wait for the reply
+ * @return  error, E_IPC_ERR_RECV_FAIL if no reply arrived in time
+ */
+IPC_eError_t IPC_call( IPC_eTaskID_t aRecv, IPC_eMsgType_t aType, const uint8_t * apReq, uint32_t aReqSize,
+                       IPC_sMsg_t * apResp, TickType_t xTicksToWait )
+{
+#if (IPC_USE_RPC == 1)
+    if (aReqSize > IPC_MAX_DATA_LENGTH) // Data cannot be sent because it's too large
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aRecv );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+    if (IPC_IS_SHARED( psHandler ) || apResp == NULL) // The other core can't write the reply
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    /* Claim a free call slot */
+    uint32_t idx = 0;
+    while (idx < IPC_CALL_CNT_MAX && !IPC_ATOMIC_CAS( &(IPC_arCall[idx].state), IPC_CALL_FREE, IPC_CALL_RESERVED ))
+    {
+        idx++;
+    }
+    if (idx == IPC_CALL_CNT_MAX) // All slots wait for a reply
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+    IPC_sCall_t * psCall = &IPC_arCall[idx];
+    psCall->seq++;
+    if ((psCall->seq & 0xFFFFFFUL) == 0) // A call ID never looks like a state
+    {
+        psCall->seq = 1;
+    }
+    uint32_t callID = IPC_CALL_ID( idx, psCall->seq );
+    psCall->caller  = xTaskGetCurrentTaskHandle();
+    psCall->resp    = apResp;
+    IPC_MEMORY_BARRIER();
+    psCall->state   = callID;
+
+    IPC_sMsg_t * psMsg;
+    IPC_eError_t error = IPC_isTailReserved( psHandler ) ? E_IPC_ERR_SEND_FAIL
+                       : IPC_queueReserveWait( psHandler, aType, aReqSize, &psMsg );
+    if (error != E_IPC_SUCCESS) // Queue is full or data too large
+    {
+        psCall->state = IPC_CALL_FREE;
+        return error;
+    }
+    IPC_sMsg_t * psData = IPC_queueData( psHandler, psMsg );
+    IPC_COPY( psData->u8Data, apReq, aReqSize );
+    psData->u32CallID = callID;
+    IPC_queueCommit( psHandler, psMsg );
+    error = IPC_notify( psHandler );
+
+    TimeOut_t xTimeOut;
+    vTaskSetTimeOutState( &xTimeOut );
+    while (psCall->state != IPC_CALL_DONE)
+    {
+        if (IPC_WAIT_TAKE( xTicksToWait ) == 0 || xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE)
+        {
+            if (IPC_ATOMIC_CAS( &(psCall->state), callID, IPC_CALL_FREE )) // Timed out, a late reply is discarded
+            {
+                return E_IPC_ERR_RECV_FAIL;
+            }
+            xTicksToWait = portMAX_DELAY;   // The reply is being written, its notification follows
+        }
+    }
+
+    IPC_MEMORY_BARRIER(); // The reply is read before the slot can be claimed again
+    psCall->state = IPC_CALL_FREE;
+    return error;
+#else
+    (void) aRecv;
+    (void) aType;
+    (void) apReq;
+    (void) aReqSize;
+    (void) apResp;
+    (void) xTicksToWait;
+    return E_IPC_ERR_INVALID;
+#endif
+}
+
+/**
+ * Answer a request sent by IPC_call()
+ * Can be called with the received copy or the borrowed message of the request.
+ * IPC_forward() keeps the call ID, so the task a request is forwarded to can
+ * answer it.
+ * @param   apReq       The request
+ * @param   aType       Message type of the reply
+ * @param   apData      Reply data
+ * @param   aDataSize   Size of reply data in bytes
+ * @return  error, E_IPC_ERR_INVALID if apReq isn't a request, E_IPC_ERR_SEND_FAIL if the caller stopped waiting
+ */
+IPC_eError_t IPC_reply( const IPC_sMsg_t * apReq, IPC_eMsgType_t aType, const uint8_t * apData, uint32_t aDataSize )
+{
+#if (IPC_USE_RPC == 1)
+    uint32_t callID = apReq->u32CallID;
+    uint32_t idx    = callID & 0xFFUL;
+    if (callID <= IPC_CALL_DONE || idx >= IPC_CALL_CNT_MAX) // Not sent by IPC_call()
+    {
+        return E_IPC_ERR_INVALID;
+    }
+    if (aDataSize > IPC_MAX_DATA_LENGTH) // Data cannot be sent because it's too large
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_sCall_t * psCall = &IPC_arCall[idx];
+    if (!IPC_ATOMIC_CAS( &(psCall->state), callID, IPC_CALL_REPLYING )) // The caller timed out or got a reply already
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_sMsg_t * psResp     = psCall->resp;
+    TaskHandle_t caller     = psCall->caller;   // The slot can be reused as soon as it is done
+    psResp->eIPC_MsgType    = aType;
+    psResp->u32DataLen      = aDataSize;
+    psResp->u32CallID       = 0;
+    IPC_COPY( psResp->u8Data, apData, aDataSize );
+
+    IPC_MEMORY_BARRIER(); // The reply is complete before the caller sees it
+    psCall->state = IPC_CALL_DONE;
+    (void) IPC_WAIT_GIVE( caller );
+    return E_IPC_SUCCESS;
+#else
+    (void) apReq;
+    (void) aType;
+    (void) apData;
+    (void) aDataSize;
+    return E_IPC_ERR_INVALID;
+#endif
+}
+
+/**
+ * Get the counters of a handler
+ * Only available if IPC_USE_STATS is 1. The counters are updated without
+ * locking, so they may be off by the messages in flight while they are read.
+ * @param   aTaskID     Receiver task ID
+ * @param   apStats     Returns the counters
+ * @return  error, E_IPC_ERR_INVALID if the statistics are disabled
+ */
+IPC_eError_t IPC_getStats( IPC_eTaskID_t aTaskID, IPC_sStats_t * apStats )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+#if (IPC_USE_STATS == 1)
+    if (apStats == NULL)
+    {
+        return E_IPC_ERR_INVALID;
+    }
+
+    IPC_sStatCnt_t * psCnt  = &(psHandler->stats);
+    apStats->u32Sent        = psCnt->sent;
+    apStats->u32Received    = psCnt->received;
+    apStats->u32Dropped     = psCnt->dropped;
+    apStats->u32Rejected    = psCnt->rejected;
+    apStats->u32HighWater   = psCnt->highWater;
+    apStats->u32LatencyMin  = psCnt->latencyMin;
+    apStats->u32LatencyMax  = psCnt->latencyMax;
+    apStats->u32LatencyAvg  = (psCnt->received > 0) ? (uint32_t) (psCnt->latencySum / psCnt->received) : 0;
+    return E_IPC_SUCCESS;
+#else
+    (void) apStats;
+    return E_IPC_ERR_INVALID;
+#endif
+}
+
+/**
+ * Reset the counters of a handler
+ * @param   aTaskID     Receiver task ID
+ * @return  error, E_IPC_ERR_INVALID if the statistics are disabled
+ */
+IPC_eError_t IPC_resetStats( IPC_eTaskID_t aTaskID )
+{
+    IPC_sHandler_t * psHandler  = IPC_getHandler( aTaskID );
+    if (psHandler == NULL) // There is no handler for this task ID
+    {
+        return E_IPC_ERR_NO_HANDLER;
+    }
+#if (IPC_USE_STATS == 1)
+    IPC_statsClear( psHandler );
+    return E_IPC_SUCCESS;
+#else
+    return E_IPC_ERR_INVALID;
+#endif
+}
+
+/**
+ * Check that a handler can be added for a task ID
+ * Must be called with IPC_CREATE_LOCK() held, until IPC_publishHandler().
+ * @param   aTaskID     Receiver task ID
+ * @return  error
+ */
+static IPC_eError_t IPC_checkNewHandler( IPC_eTaskID_t aTaskID )
+{
+#if defined(IPC_TOPOLOGY)
+    (void) aTaskID;
+    return E_IPC_ERR_INVALID;   // The table is fixed at compile time, the create paths never touch it
+#else
+    if ((uint32_t) aTaskID >= IPC_TASK_ID_CNT || IPC_u8HandlerCnt == IPC_HANDLER_CNT_MAX) // There is no space for more handlers
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+    else if (IPC_getHandler( aTaskID ) != NULL)  // A handler already exists for this task ID
+    {
+        return E_IPC_ERR_EXISTS;
+    }
+    else
+    {
+        return E_IPC_SUCCESS;
+    }
+#endif
+}
+
+/**
+ * Take the next free entry of the handler table
+ * The handler can't be found until IPC_publishHandler() is called.
+ * @param   aTaskID     Receiver task ID
+ * @param   aHandle     Receiver task handle
+ * @param   aKind       Storage backend of the handler
+ * @return  handler
+ */
+static IPC_sHandler_t * IPC_addHandler( IPC_eTaskID_t aTaskID, TaskHandle_t aHandle, IPC_eQueueKind_t aKind )
+{
+    IPC_sHandler_t * psHandler = IPC_HANDLER_AT( IPC_u8HandlerCnt );
+    psHandler->recvId               = aTaskID;
+    psHandler->handle               = aHandle;
+    psHandler->kind                 = aKind;
+    psHandler->reserved             = 0;
+    psHandler->reservedMsg          = NULL;
+    psHandler->notifyPending        = 0;
+    psHandler->waiters              = 0;
+#if (IPC_USE_DMA == 1)
+    psHandler->dmaThreshold         = 0;
+    psHandler->dmaLen               = 0;
+#endif
+    psHandler->policy               = E_IPC_OVERFLOW_REJECT;
+    psHandler->blockTicks           = 0;
+    psHandler->notifyIndex          = IPC_NOTIFY_INDEX;
+    psHandler->notifyBits           = 0;
+    psHandler->recvLane             = 0;
+
+    for (uint32_t i = 0; i < E_IPC_MSG_TYPE_CNT; i++)
+    {
+        psHandler->typeLane[i]      = 0;
+        psHandler->callback[i]      = NULL;
+    }
+#if (IPC_USE_MULTICORE == 1)
+    psHandler->shared               = 0;
+    for (uint32_t l = 0; l < IPC_LANE_CNT; l++)
+    {
+        psHandler->apLane[l]        = &(psHandler->lane[l]);
+    }
+#endif
+    for (uint32_t l = 0; l < IPC_LANE_CNT; l++)
+    {
+        IPC_LANE( psHandler, l )->queueLength  = 0;    // A lane without slots never has messages
+        IPC_LANE( psHandler, l )->queueTail    = 0;
+        IPC_LANE( psHandler, l )->queueHead    = 0;
+    }
+#if (IPC_USE_STATS == 1)
+    IPC_statsClear( psHandler );
+#endif
+
+    return psHandler;
+}
+
+/**
+ * Make a completely initialized handler visible to senders and IPC_select()
+ * @param   psHandler   Handler taken by IPC_addHandler()
+ */
+static void IPC_publishHandler( IPC_sHandler_t * psHandler )
+{
+#if defined(IPC_TOPOLOGY)
+    (void) psHandler;   // Never called, the lookup table is constant and IPC_checkNewHandler() refuses
+#else
+    IPC_MEMORY_BARRIER(); // Tasks on other cores never see a handler before its queue
+    IPC_apHandlerLut[psHandler->recvId] = psHandler;
+    IPC_u8HandlerCnt++;
+#endif
+}
+
+/**
+ * Create a handler with a slot queue on the given storage
+ * @param   aTaskID         Receiver task ID
+ * @param   aHandle         Receiver task handle
+ * @param   aQueueLength    Number of message slots
+ * @param   aMaxDataLen     The maximum data size of a message
+ * @param   apStorage       Storage for the message slots
+ * @return  error
+ */
+static IPC_eError_t IPC_addSlotHandler( IPC_eTaskID_t aTaskID, TaskHandle_t aHandle, uint32_t aQueueLength,
+                                        uint32_t aMaxDataLen, uint8_t * apStorage )
+{
+    if (aQueueLength == 0 || aMaxDataLen > IPC_MAX_DATA_LENGTH)
+    {
+        return E_IPC_ERR_CREATE_FAIL;
+    }
+
+    IPC_CREATE_LOCK();
+    IPC_eError_t error = IPC_checkNewHandler( aTaskID );
+    if (error == E_IPC_SUCCESS)
+    {
+        /*
+        * Initialize IPC handler
+        */
+        IPC_sHandler_t * psHandler = IPC_addHandler( aTaskID, aHandle, E_IPC_QUEUE_SLOTS );
+        IPC_initQueue( IPC_LANE( psHandler, 0 ), aQueueLength, aMaxDataLen, apStorage );
+        IPC_publishHandler( psHandler );
+    }
+    IPC_CREATE_UNLOCK();
+
+    return error;
+}
+
+/**
+ * Set up an empty slot queue on the given storage
+ * @param   queue           Message queue
+ * @param   aQueueLength    Number of message slots
+ * @param   aMaxDataLen     The maximum data size of a message
+ * @param   apStorage       Storage for the message slots
+ */
+static void IPC_initQueue( IPC_sMsgQueue_t * queue, uint32_t aQueueLength, uint32_t aMaxDataLen, uint8_t * apStorage )
+{
+    queue->msgQueue         = apStorage;
+    queue->multiProducer    = 0;
+    queue->borrowed         = 0;
+#if (IPC_USE_SMP == 1)
+    queue->lock             = 0;
+#endif
+    queue->slotSize         = IPC_SLOT_SIZE( aMaxDataLen );
+    queue->maxDataLen       = aMaxDataLen;
+    queue->queueLength      = aQueueLength;
+    queue->queueTail        = 0;
+    queue->queueHead        = 0;
+
+    for (uint32_t i = 0; i < aQueueLength; i++)
+    {
+        IPC_SLOT_HDR( IPC_SLOT( queue, i ) )->ready = 0;
+        IPC_SLOT_HDR( IPC_SLOT( queue, i ) )->ref   = NULL;
+    }
+}
+
+/**
+ * Get the lane a message type is sent to
+ * @param   psHandler   Receiver IPC handler
+ * @param   aType       Message type
+ * @return  message queue of the lane
+ */
+static inline IPC_sMsgQueue_t * IPC_typeQueue( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType )
+{
+    uint32_t lane = ((uint32_t) aType < E_IPC_MSG_TYPE_CNT) ? psHandler->typeLane[aType] : 0;
+    return IPC_LANE( psHandler, lane );
+}
+
+/**
+ * Get the lane a slot belongs to
+ * @param   psHandler   Receiver IPC handler
+ * @param   psMsg       Message of a slot
+ * @return  message queue of the lane
+ */
+static inline IPC_sMsgQueue_t * IPC_slotQueue( IPC_sHandler_t * psHandler, const IPC_sMsg_t * psMsg )
+{
+    for (uint32_t l = IPC_LANE_CNT - 1; l > 0; l--)
+    {
+        IPC_sMsgQueue_t * queue = IPC_LANE( psHandler, l );
+        if ((const uint8_t *) psMsg >= queue->msgQueue
+            && (const uint8_t *) psMsg < queue->msgQueue + queue->queueLength * queue->slotSize)
+        {
+            return queue;
+        }
+    }
+
+    return IPC_LANE( psHandler, 0 );
+}
+
+/**
+ * Get the highest lane that has messages
+ * @param   psHandler   Receiver IPC handler
+ * @return  lane number, 0 if all lanes are empty
+ */
+static uint32_t IPC_recvLane( const IPC_sHandler_t * psHandler )
+{
+    for (uint32_t l = IPC_LANE_CNT - 1; l > 0; l--)
+    {
+        const IPC_sMsgQueue_t * queue = IPC_LANE( psHandler, l );
+        if (queue->queueTail != queue->queueHead)
+        {
+            return l;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Get the number of messages in all lanes of a slot queue handler
+ * @param   psHandler   Receiver IPC handler
+ * @return  number of messages
+ */
+static uint32_t IPC_slotCount( const IPC_sHandler_t * psHandler )
+{
+    uint32_t count = 0;
+
+    IPC_SHARED_FETCH( psHandler, IPC_LANE( psHandler, 0 ) ); // Only lane 0 is in the shared memory
+    for (uint32_t l = 0; l < IPC_LANE_CNT; l++)
+    {
+        const IPC_sMsgQueue_t * queue = IPC_LANE( psHandler, l );
+        count += IPC_queueCount( queue, queue->queueTail, queue->queueHead );
+    }
+
+    return count;
+}
+
+/**
+ * Get the slot an index of the queue refers to
+ * @param   queue     Message queue
+ * @param   idx       Head or tail index (0 .. 2 * queueLength - 1)
+ * @return  slot number
+ */
+static inline uint32_t IPC_slotIdx( const IPC_sMsgQueue_t * queue, uint32_t idx )
+{
+    return (idx < queue->queueLength) ? idx : idx - queue->queueLength;
+}
+
+/**
+ * Increment a head or tail index - don't use modulo because it might be slower
+ * @param   queue     Message queue
+ * @param   idx       Head or tail index
+ * @return  next index
+ */
+static inline uint32_t IPC_nextIdx( const IPC_sMsgQueue_t * queue, uint32_t idx )
+{
+    return (idx == 2 * queue->queueLength - 1) ? 0 : idx + 1;
+}
+
+/**
+ * Get the number of messages in the queue
+ * @param   queue     Message queue
+ * @param   tail      Tail index
+ * @param   head      Head index
+ * @return  messages between head and tail
+ */
+static inline uint32_t IPC_queueCount( const IPC_sMsgQueue_t * queue, uint32_t tail, uint32_t head )
+{
+    return (tail >= head) ? tail - head : tail + 2 * queue->queueLength - head;
+}
+
+/**
+ * Check if IPC_send() would hit the slot reserved by IPC_sendReserve()
+ * @param   psHandler   Receiver IPC handler
+ * @return  true if the next message must not be written
+ */
+static inline uint32_t IPC_isTailReserved( const IPC_sHandler_t * psHandler )
+{
+    /* In MPSC mode the reservation owns its own claimed slot */
+    return psHandler->reserved && !(psHandler->kind == E_IPC_QUEUE_SLOTS && IPC_LANE( psHandler, 0 )->multiProducer);
+}
+
+/**
+ * Get the next free message of the handler's queue
+ * The message header is filled in, the payload has to be written by the caller
+ * to IPC_queueData( psHandler, *ppsMsg ). Payloads that don't fit into a slot
+ * are stored in a block of the message pool, the slot only refers to it.
+ * @param   psHandler   Receiver IPC handler
+ * @param   aType       Message type
+ * @param   aDataSize   Size of message data in bytes
+ * @param   ppsMsg      Returns the message to be committed
+ * @return  E_IPC_SUCCESS, E_IPC_ERR_QUEUE_FULL or E_IPC_ERR_SEND_FAIL if the data is too large
+ */
+static IPC_eError_t IPC_queueReserve( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType, uint32_t aDataSize, IPC_sMsg_t ** ppsMsg )
+{
+    IPC_sMsg_t * psMsg;
+    IPC_sMsg_t * psData;
+
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        IPC_eError_t error = IPC_ringReserve( &(psHandler->ring), aDataSize, &psMsg );
+        if (error != E_IPC_SUCCESS)
+        {
+            return error;
+        }
+        psData = psMsg;
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        if (aDataSize > psHandler->mbox.maxDataLen) // Data doesn't fit into a buffer of this handler
+        {
+            return E_IPC_ERR_SEND_FAIL;
+        }
+        psMsg   = IPC_MBOX( &(psHandler->mbox), psHandler->mbox.back );    // The back buffer is always free
+        psData  = psMsg;
+    }
+    else
+    {
+        IPC_sMsgQueue_t * queue = IPC_typeQueue( psHandler, aType );
+        IPC_sMsg_t * psBlock    = NULL;
+        if (aDataSize > queue->maxDataLen) // Data doesn't fit into a slot of this handler
+        {
+            if (IPC_IS_SHARED( psHandler )) // The other core can't access the pool
+            {
+                return E_IPC_ERR_SEND_FAIL;
+            }
+            /* Take the block before the slot, a claimed slot can't be given back */
+            IPC_eError_t error = IPC_poolAlloc( aDataSize, &psBlock );
+            if (error != E_IPC_SUCCESS)
+            {
+                return error;
+            }
+        }
+        uint32_t tail;
+        uint32_t claimed;
+        IPC_SHARED_FETCH( psHandler, queue );
+        if (queue->multiProducer)
+        {
+            /* While this sender can't be preempted, the other senders can't move the tail once around to the same index */
+            IPC_ENTER_CRITICAL();
+            do
+            {
+                tail    = queue->queueTail;
+                claimed = (IPC_queueCount( queue, tail, queue->queueHead ) < queue->queueLength);
+            } while (claimed && !IPC_ATOMIC_CAS( &(queue->queueTail), tail, IPC_nextIdx( queue, tail ) ));
+            IPC_EXIT_CRITICAL();
+        }
+        else
+        {
+            tail    = queue->queueTail;
+            claimed = (IPC_queueCount( queue, tail, queue->queueHead ) < queue->queueLength) || IPC_dropOldest( psHandler, queue );
+        }
+        if (!claimed) // Queue is full
+        {
+            if (psBlock != NULL)
+            {
+                IPC_poolFree( psBlock );
+            }
+            return E_IPC_ERR_QUEUE_FULL;
+        }
+
+        IPC_MEMORY_BARRIER(); // The receiver is done with the slot before it is written
+        psMsg = IPC_SLOT( queue, tail );
+        IPC_SLOT_HDR( psMsg )->ref = psBlock;
+        psData = (psBlock != NULL) ? psBlock : psMsg;
+    }
+
+    psData->eIPC_MsgType = aType;
+    psData->u32DataLen   = aDataSize;
+#if (IPC_USE_RPC == 1)
+    psData->u32CallID    = 0;
+#endif
+    *ppsMsg = psMsg;
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Make room in a full queue by dropping the oldest message
+ * Only handlers with E_IPC_OVERFLOW_OVERWRITE do this. The message the receiver
+ * is currently reading is never dropped.
+ * @param   psHandler   Receiver IPC handler
+ * @param   queue       The full lane of the handler
+ * @return  true if a message has been dropped
+ */
+static uint32_t IPC_dropOldest( IPC_sHandler_t * psHandler, IPC_sMsgQueue_t * queue )
+{
+    uint32_t dropped        = 0;
+
+    if (psHandler->policy == E_IPC_OVERFLOW_OVERWRITE)
+    {
+        IPC_QUEUE_LOCK( queue );
+        if (!queue->borrowed)
+        {
+            IPC_slotClear( IPC_SLOT( queue, queue->queueHead ) );
+            queue->queueHead    = IPC_nextIdx( queue, queue->queueHead );
+            dropped             = 1;
+        }
+        IPC_QUEUE_UNLOCK( queue );
+    }
+    if (dropped)
+    {
+        IPC_STATS_ADD( psHandler->stats.dropped );
+    }
+
+    return dropped;
+}
+
+/**
+ * Get the next free message of the handler's queue from task context
+ * Works like IPC_queueReserve(), but a handler with E_IPC_OVERFLOW_BLOCK waits
+ * up to its timeout for a free message.
+ * @param   psHandler   Receiver IPC handler
+ * @param   aType       Message type
+ * @param   aDataSize   Size of message data in bytes
+ * @param   ppsMsg      Returns the message to be filled
+ * @return  error
+ */
+static IPC_eError_t IPC_queueReserveWait( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType, uint32_t aDataSize, IPC_sMsg_t ** ppsMsg )
+{
+    IPC_eError_t error = IPC_queueReserve( psHandler, aType, aDataSize, ppsMsg );
+
+    if (error == E_IPC_ERR_QUEUE_FULL && psHandler->policy == E_IPC_OVERFLOW_BLOCK)
+    {
+        TimeOut_t   xTimeOut;
+        TickType_t  xTicksToWait = psHandler->blockTicks;
+        uint32_t    need         = (psHandler->kind == E_IPC_QUEUE_RING) ? IPC_RING_RECORD_SIZE( aDataSize ) : 1;
+        uint32_t    poolLen      = (psHandler->kind == E_IPC_QUEUE_SLOTS && aDataSize > IPC_typeQueue( psHandler, aType )->maxDataLen) ? aDataSize : 0;
+
+        vTaskSetTimeOutState( &xTimeOut );
+        while (error == E_IPC_ERR_QUEUE_FULL && xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE)
+        {
+            (void) IPC_spaceWait( psHandler, aType, need, poolLen, xTicksToWait );
+            error = IPC_queueReserve( psHandler, aType, aDataSize, ppsMsg );
+        }
+    }
+    if (error == E_IPC_ERR_QUEUE_FULL)
+    {
+        IPC_STATS_ADD( psHandler->stats.rejected );
+    }
+
+    return error;
+}
+
+/**
+ * Publish the message got by IPC_queueReserve()
+ * @param   psHandler   Receiver IPC handler
+ * @param   psMsg       The message returned by IPC_queueReserve()
+ */
+static void IPC_queueCommit( IPC_sHandler_t * psHandler, IPC_sMsg_t * psMsg )
+{
+    IPC_STATS_STAMP( psHandler, psMsg );
+    IPC_SHARED_PUBLISH_MSG( psHandler, psMsg );
+    IPC_MEMORY_BARRIER(); // The message is complete before the receiver can see it
+
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        psHandler->ring.ringTail = psHandler->ring.ringNext;
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        IPC_mboxCommit( psHandler );
+    }
+    else
+    {
+        IPC_sMsgQueue_t * queue = IPC_slotQueue( psHandler, psMsg );
+        if (queue->multiProducer) // The slot has already been claimed
+        {
+            IPC_SLOT_HDR( psMsg )->ready = 1;
+        }
+        else
+        {
+            queue->queueTail = IPC_nextIdx( queue, queue->queueTail );
+            IPC_SHARED_PUBLISH( psHandler, queue );
+        }
+    }
+    IPC_STATS_SENT( psHandler );
+}
+
+/**
+ * Notify the receiver task about a new message
+ * @param   psHandler   Receiver IPC handler
+ * @return  error
+ */
+static IPC_eError_t IPC_notify( IPC_sHandler_t * psHandler )
+{
+#if (IPC_USE_MULTICORE == 1) || defined(IPC_TOPOLOGY)
+    if (psHandler->handle == NULL) // The receiver is on the other core or isn't bound yet
+    {
+#if (IPC_USE_MULTICORE == 1)
+        if (IPC_IS_SHARED( psHandler ))
+        {
+            IPC_REMOTE_NOTIFY( psHandler->recvId );
+        }
+#endif
+        return E_IPC_SUCCESS;
+    }
+#endif
+
+    BaseType_t xResult;
+    if (psHandler->notifyBits != 0) // The receiver waits in IPC_select()
+    {
+        xResult = IPC_NOTIFY_BITS( psHandler );
+    }
+    else
+    {
+        xResult = IPC_NOTIFY_GIVE( psHandler );
+    }
+
+    if (pdPASS == xResult)  // Notify task
+    {
+        return E_IPC_SUCCESS;
+    }
+    else
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+}
+
+/**
+ * Notify the receiver task about a new message from an interrupt service routine
+ * @param   psHandler                   Receiver IPC handler
+ * @param   pxHigherPriorityTaskWoken   Set to pdTRUE if the receiver should run on ISR exit (may be NULL)
+ */
+static void IPC_notifyFromISR( IPC_sHandler_t * psHandler, BaseType_t * pxHigherPriorityTaskWoken )
+{
+#if (IPC_USE_MULTICORE == 1) || defined(IPC_TOPOLOGY)
+    if (psHandler->handle == NULL) // The receiver is on the other core or isn't bound yet
+    {
+#if (IPC_USE_MULTICORE == 1)
+        if (IPC_IS_SHARED( psHandler ))
+        {
+            IPC_REMOTE_NOTIFY( psHandler->recvId );
+        }
+#endif
+        return;
+    }
+#endif
+
+    if (psHandler->notifyBits != 0) // The receiver waits in IPC_select()
+    {
+        (void) IPC_NOTIFY_BITS_FROM_ISR( psHandler, pxHigherPriorityTaskWoken );
+    }
+    else
+    {
+        IPC_NOTIFY_GIVE_FROM_ISR( psHandler, pxHigherPriorityTaskWoken );
+    }
+}
+
+/**
+ * Check if there is a message in the handler's queue
+ * @param   psHandler   Receiver IPC handler
+ * @return  true if there is a message
+ */
+static uint32_t IPC_hasData( const IPC_sHandler_t * psHandler )
+{
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        return psHandler->ring.ringHead != psHandler->ring.ringTail;
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        return psHandler->mbox.unread || (psHandler->mbox.middle & IPC_MBOX_NEW);
+    }
+
+    return IPC_slotCount( psHandler ) > 0;
+}
+
+/**
+ * Get the select bits of a task's handlers that have messages
+ * @param   aHandle     Receiver task handle
+ * @param   aBits       Select bits to check
+ * @param   ppsFirst    Returns one of the checked handlers, NULL if there is none
+ * @return  select bits of the handlers with messages
+ */
+static uint32_t IPC_selectReady( TaskHandle_t aHandle, uint32_t aBits, IPC_sHandler_t ** ppsFirst )
+{
+    uint32_t ready  = 0;
+    *ppsFirst       = NULL;
+
+    for (uint32_t i = 0; i < IPC_u8HandlerCnt; i++)
+    {
+        IPC_sHandler_t * psHandler = IPC_HANDLER_AT( i );
+        if (psHandler->handle != aHandle || (psHandler->notifyBits & aBits) == 0)
+        {
+            continue;
+        }
+
+        *ppsFirst = psHandler;
+        if (IPC_hasData( psHandler ))
+        {
+            ready |= psHandler->notifyBits;
+        }
+    }
+
+    return ready;
+}
+
+/**
+ * Get the oldest message of the handler's queue without removing it
+ * @param   psHandler   Receiver IPC handler
+ * @param   ppsMsg      Returns the oldest message
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE or E_IPC_ERR_RECV_FAIL if the queue is empty
+ */
+static IPC_eError_t IPC_queuePeek( IPC_sHandler_t * psHandler, IPC_sMsg_t ** ppsMsg )
+{
+    psHandler->recvLane = IPC_recvLane( psHandler );
+    return IPC_queuePeekLane( psHandler, ppsMsg );
+}
+
+/**
+ * Get the oldest message of the lane the receiver is reading without removing it
+ * @param   psHandler   Receiver IPC handler
+ * @param   ppsMsg      Returns the oldest message
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE or E_IPC_ERR_RECV_FAIL if the lane is empty
+ */
+static IPC_eError_t IPC_queuePeekLane( IPC_sHandler_t * psHandler, IPC_sMsg_t ** ppsMsg )
+{
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        return IPC_ringPeek( &(psHandler->ring), ppsMsg );
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        return IPC_mboxPeek( &(psHandler->mbox), ppsMsg );
+    }
+
+    IPC_sMsgQueue_t * queue     = IPC_LANE( psHandler, psHandler->recvLane );
+    uint32_t head;
+    uint32_t count;
+    if (psHandler->policy == E_IPC_OVERFLOW_OVERWRITE)
+    {
+        /* The sender may move the head, so take it and protect the slot in one go */
+        IPC_QUEUE_LOCK( queue );
+        head            = queue->queueHead;
+        count           = IPC_queueCount( queue, queue->queueTail, head );
+        queue->borrowed = (count > 0);
+        IPC_QUEUE_UNLOCK( queue );
+    }
+    else
+    {
+        IPC_SHARED_FETCH( psHandler, queue );
+        head            = queue->queueHead;
+        count           = IPC_queueCount( queue, queue->queueTail, head );
+    }
+
+    if (count == 0)  // Nothing to be received
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    IPC_sMsg_t * psMsg = IPC_SLOT( queue, head );
+    if (queue->multiProducer && !IPC_SLOT_HDR( psMsg )->ready)  // Claimed, but the sender is still writing
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    IPC_MEMORY_BARRIER(); // Don't read the message before the tail or ready flag that published it
+    IPC_SHARED_FETCH_MSG( psHandler, queue, psMsg );
+    *ppsMsg = IPC_slotMsg( psMsg );
+
+    if (count > 1 || IPC_slotCount( psHandler ) > 1) // There is more data in the queue to be received
+    {
+        return E_IPC_RECV_MORE;
+    }
+    else
+    {
+        return E_IPC_SUCCESS;
+    }
+}
+
+/**
+ * Remove the oldest message from the handler's queue
+ * Must only be called after IPC_queuePeek() found a message.
+ * @param   psHandler   Receiver IPC handler
+ * @return  E_IPC_RECV_MORE if there are messages left, else E_IPC_SUCCESS
+ */
+static IPC_eError_t IPC_queueRelease( IPC_sHandler_t * psHandler )
+{
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+#if (IPC_USE_STATS == 1)
+        IPC_sMsg_t * psMsg;
+        (void) IPC_ringNextRecord( &(psHandler->ring), psHandler->ring.ringHead, &psMsg );
+        IPC_statsReceived( psHandler, psMsg );
+#endif
+        IPC_eError_t error = IPC_ringRelease( &(psHandler->ring) );
+        IPC_spaceReturned( psHandler );
+        return error;
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        IPC_STATS_RECEIVED( psHandler, IPC_MBOX( &(psHandler->mbox), psHandler->mbox.front ) );
+        psHandler->mbox.unread = 0;
+        return (psHandler->mbox.middle & IPC_MBOX_NEW) ? E_IPC_RECV_MORE : E_IPC_SUCCESS;
+    }
+
+    IPC_sMsgQueue_t * queue     = IPC_LANE( psHandler, psHandler->recvLane );
+    uint32_t head               = queue->queueHead;
+
+    IPC_STATS_RECEIVED( psHandler, IPC_slotMsg( IPC_SLOT( queue, head ) ) );
+    IPC_slotClear( IPC_SLOT( queue, head ) );
+    head = IPC_nextIdx( queue, head );
+
+    IPC_MEMORY_BARRIER(); // The message has been read and the flag cleared before the slot is handed back
+    if (psHandler->policy == E_IPC_OVERFLOW_OVERWRITE)
+    {
+        IPC_QUEUE_LOCK( queue );
+        queue->queueHead    = head;
+        queue->borrowed     = 0;
+        IPC_QUEUE_UNLOCK( queue );
+    }
+    else
+    {
+        queue->queueHead    = head;
+        IPC_SHARED_PUBLISH( psHandler, queue );
+    }
+    IPC_spaceReturned( psHandler );
+
+    if (IPC_slotCount( psHandler ) > 0) // There is more data in the queue to be received
+    {
+        return E_IPC_RECV_MORE;
+    }
+    else  // All data has been received
+    {
+        return E_IPC_SUCCESS;
+    }
+}
+
+/**
+ * Get up to aMaxCount of the oldest messages without removing them
+ * @param   psHandler   Receiver IPC handler
+ * @param   appsMsg     Returns the messages, oldest first
+ * @param   aMaxCount   Max. number of messages
+ * @return  number of messages
+ */
+static uint32_t IPC_queuePeekBatch( IPC_sHandler_t * psHandler, IPC_sMsg_t ** appsMsg, uint32_t aMaxCount )
+{
+    uint32_t count = 0;
+
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        IPC_sByteRing_t * ring  = &(psHandler->ring);
+        uint32_t tail           = ring->ringTail;
+        uint32_t pos            = ring->ringHead;
+
+        IPC_MEMORY_BARRIER(); // Don't read the records before the tail that published them
+        while (count < aMaxCount && pos != tail)
+        {
+            pos = IPC_ringNextRecord( ring, pos, &appsMsg[count] );
+            count++;
+        }
+        return count;
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        /* Only the latest message is kept, so a batch has one message at most */
+        return (aMaxCount > 0 && IPC_mboxPeek( &(psHandler->mbox), &appsMsg[0] ) != E_IPC_ERR_RECV_FAIL) ? 1 : 0;
+    }
+
+    /* A batch is taken from one lane only, so it can be released in one go */
+    psHandler->recvLane         = IPC_recvLane( psHandler );
+    IPC_sMsgQueue_t * queue     = IPC_LANE( psHandler, psHandler->recvLane );
+    uint32_t head;
+    uint32_t avail;
+    if (psHandler->policy == E_IPC_OVERFLOW_OVERWRITE)
+    {
+        IPC_QUEUE_LOCK( queue );
+        head            = queue->queueHead;
+        avail           = IPC_queueCount( queue, queue->queueTail, head );
+        queue->borrowed = (avail > 0);
+        IPC_QUEUE_UNLOCK( queue );
+    }
+    else
+    {
+        IPC_SHARED_FETCH( psHandler, queue );
+        head            = queue->queueHead;
+        avail           = IPC_queueCount( queue, queue->queueTail, head );
+    }
+
+    IPC_MEMORY_BARRIER(); // Don't read the messages before the tail that published them
+    while (count < aMaxCount && count < avail)
+    {
+        IPC_sMsg_t * psMsg = IPC_SLOT( queue, head );
+        if (queue->multiProducer && !IPC_SLOT_HDR( psMsg )->ready)  // Claimed, but the sender is still writing
+        {
+            break;
+        }
+
+        appsMsg[count++] = psMsg;
+        head = IPC_nextIdx( queue, head );
+    }
+
+    IPC_MEMORY_BARRIER(); // Don't read messages before their ready flag
+    for (uint32_t i = 0; i < count; i++)
+    {
+        IPC_SHARED_FETCH_MSG( psHandler, queue, appsMsg[i] );
+        appsMsg[i] = IPC_slotMsg( appsMsg[i] );
+    }
+    return count;
+}
+
+/**
+ * Remove the aCount oldest messages from the handler's queue
+ * Should only be called after IPC_queuePeekBatch() found aCount messages. A
+ * larger count is clamped to the messages the queue holds.
+ * @param   psHandler   Receiver IPC handler
+ * @param   aCount      Number of messages to remove
+ * @return  E_IPC_RECV_MORE if there are messages left, else E_IPC_SUCCESS
+ */
+static IPC_eError_t IPC_queueReleaseBatch( IPC_sHandler_t * psHandler, uint32_t aCount )
+{
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        IPC_sByteRing_t * ring  = &(psHandler->ring);
+        uint32_t pos            = ring->ringHead;
+        IPC_sMsg_t * psMsg;
+
+        for (uint32_t i = 0; i < aCount && pos != ring->ringTail; i++)
+        {
+            pos = IPC_ringNextRecord( ring, pos, &psMsg );
+            IPC_STATS_RECEIVED( psHandler, psMsg );
+        }
+
+        IPC_MEMORY_BARRIER(); // The records have been read before the space is handed back
+        ring->ringHead = pos;
+        IPC_spaceReturned( psHandler );
+        return (pos != ring->ringTail) ? E_IPC_RECV_MORE : E_IPC_SUCCESS;
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        return IPC_queueRelease( psHandler );
+    }
+
+    IPC_sMsgQueue_t * queue     = IPC_LANE( psHandler, psHandler->recvLane );
+    uint32_t head               = queue->queueHead;
+    uint32_t avail              = IPC_queueCount( queue, queue->queueTail, head );
+
+    for (uint32_t i = 0; i < aCount && i < avail; i++)
+    {
+        if (queue->multiProducer && !IPC_SLOT_HDR( IPC_SLOT( queue, head ) )->ready)  // Claimed, but never borrowed
+        {
+            break;
+        }
+        IPC_STATS_RECEIVED( psHandler, IPC_slotMsg( IPC_SLOT( queue, head ) ) );
+        IPC_slotClear( IPC_SLOT( queue, head ) );
+        head = IPC_nextIdx( queue, head );
+    }
+
+    IPC_MEMORY_BARRIER(); // The messages have been read and the flags cleared before the slots are handed back
+    if (psHandler->policy == E_IPC_OVERFLOW_OVERWRITE)
+    {
+        IPC_QUEUE_LOCK( queue );
+        queue->queueHead    = head;
+        queue->borrowed     = 0;
+        IPC_QUEUE_UNLOCK( queue );
+    }
+    else
+    {
+        queue->queueHead    = head;
+        IPC_SHARED_PUBLISH( psHandler, queue );
+    }
+    IPC_spaceReturned( psHandler );
+
+    if (IPC_slotCount( psHandler ) > 0) // There is more data in the queue to be received
+    {
+        return E_IPC_RECV_MORE;
+    }
+    else  // All data has been received
+    {
+        return E_IPC_SUCCESS;
+    }
+}
+
+/**
+ * Check if there are more than aCount messages in the handler's queue
+ * @param   psHandler   Receiver IPC handler
+ * @param   aCount      Number of messages already seen
+ * @return  true if there are more messages
+ */
+static uint32_t IPC_queueHasMore( IPC_sHandler_t * psHandler, uint32_t aCount )
+{
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        /* The ring doesn't know its element count, so walk the records */
+        IPC_sByteRing_t * ring  = &(psHandler->ring);
+        uint32_t pos            = ring->ringHead;
+        IPC_sMsg_t * psMsg;
+
+        for (uint32_t i = 0; i < aCount; i++)
+        {
+            pos = IPC_ringNextRecord( ring, pos, &psMsg );
+        }
+        return pos != ring->ringTail;
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        return (aCount == 0 && psHandler->mbox.unread) || (psHandler->mbox.middle & IPC_MBOX_NEW);
+    }
+
+    return IPC_slotCount( psHandler ) > aCount;
+}
+
+/**
+ * Publish the back buffer of a mailbox as its newest message
+ * The back buffer is swapped with the middle one, which the sender writes
+ * next. If the receiver hasn't taken the middle message, it is dropped.
+ * @param   psHandler   Receiver IPC handler
+ */
+static void IPC_mboxCommit( IPC_sHandler_t * psHandler )
+{
+    IPC_sMailbox_t * mbox   = &(psHandler->mbox);
+    uint32_t middle;
+
+    do
+    {
+        middle = mbox->middle;
+    } while (!IPC_ATOMIC_CAS( &(mbox->middle), middle, mbox->back | IPC_MBOX_NEW ));
+
+    mbox->back = middle & IPC_MBOX_IDX_MASK;
+    if (middle & IPC_MBOX_NEW) // The receiver never saw this message
+    {
+        IPC_STATS_ADD( psHandler->stats.dropped );
+    }
+}
+
+/**
+ * Get the latest message of a mailbox without removing it
+ * A message that has been peeked is returned again until it is released, only
+ * then the receiver takes a newer one from the middle buffer.
+ * @param   mbox        Mailbox
+ * @param   ppsMsg      Returns the latest message
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE or E_IPC_ERR_RECV_FAIL if there is no new message
+ */
+static IPC_eError_t IPC_mboxPeek( IPC_sMailbox_t * mbox, IPC_sMsg_t ** ppsMsg )
+{
+    if (!mbox->unread && (mbox->middle & IPC_MBOX_NEW))
+    {
+        /* Only the receiver clears IPC_MBOX_NEW, so the flag is still set if the sender swapped meanwhile */
+        uint32_t middle;
+        do
+        {
+            middle = mbox->middle;
+        } while (!IPC_ATOMIC_CAS( &(mbox->middle), middle, mbox->front ));
+
+        mbox->front     = middle & IPC_MBOX_IDX_MASK;
+        mbox->unread    = 1;
+    }
+    if (!mbox->unread) // Nothing to be received
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    IPC_MEMORY_BARRIER(); // Don't read the message before the swap that handed it over
+    *ppsMsg = IPC_MBOX( mbox, mbox->front );
+    return (mbox->middle & IPC_MBOX_NEW) ? E_IPC_RECV_MORE : E_IPC_SUCCESS;
+}
+
+/**
+ * Get the record at an offset of the byte ring and the offset behind it
+ * There must be a record at aPos, a wrap marker is skipped.
+ * @param   ring        Byte ring
+ * @param   aPos        Offset of a record or wrap marker
+ * @param   ppsMsg      Returns the record
+ * @return  offset of the next record
+ */
+static uint32_t IPC_ringNextRecord( const IPC_sByteRing_t * ring, uint32_t aPos, IPC_sMsg_t ** ppsMsg )
+{
+    IPC_sMsg_t * psMsg = (IPC_sMsg_t *) &(ring->ringBuf[aPos]);
+    if (psMsg->u32DataLen == IPC_RING_WRAP_MARKER)  // Remaining bytes at the end are unused
+    {
+        aPos    = 0;
+        psMsg   = (IPC_sMsg_t *) ring->ringBuf;
+    }
+
+    aPos += IPC_RING_RECORD_SIZE( psMsg->u32DataLen );
+    if (aPos == ring->ringSize)
+    {
+        aPos = 0;
+    }
+
+    *ppsMsg = psMsg;
+    return aPos;
+}
+
+/**
+ * Find space for a record in the byte ring
+ * The tail is not moved before IPC_queueCommit(), so the reader can't see the
+ * record while it is being written.
+ * @param   ring        Byte ring
+ * @param   aDataSize   Size of message data in bytes
+ * @param   ppsMsg      Returns the record to be filled
+ * @return  E_IPC_SUCCESS, E_IPC_ERR_QUEUE_FULL or E_IPC_ERR_SEND_FAIL if the record never fits
+ */
+static IPC_eError_t IPC_ringReserve( IPC_sByteRing_t * ring, uint32_t aDataSize, IPC_sMsg_t ** ppsMsg )
+{
+    uint32_t recSize    = IPC_RING_RECORD_SIZE( aDataSize );
+    uint32_t tail       = ring->ringTail;
+    uint32_t head       = ring->ringHead;
+    uint32_t next;
+
+    if (recSize >= ring->ringSize) // The record is larger than the whole ring
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+
+    IPC_MEMORY_BARRIER(); // The receiver is done with the space before it is written
+
+    if (tail >= head)
+    {
+        if (recSize < ring->ringSize - tail || (recSize == ring->ringSize - tail && head != 0))
+        {
+            /* Fits in front of the buffer end */
+            next = tail + recSize;
+        }
+        else if (recSize < head)
+        {
+            /* Start over at the beginning, the reader skips the rest of the buffer */
+            ((IPC_sMsg_t *) &(ring->ringBuf[tail]))->u32DataLen = IPC_RING_WRAP_MARKER;
+            tail = 0;
+            next = recSize;
+        }
+        else
+        {
+            return E_IPC_ERR_QUEUE_FULL;
+        }
+    }
+    else if (recSize < head - tail)
+    {
+        next = tail + recSize;
+    }
+    else
+    {
+        return E_IPC_ERR_QUEUE_FULL;
+    }
+
+    if (next == ring->ringSize)
+    {
+        next = 0;
+    }
+
+    ring->ringNext  = next;
+    *ppsMsg         = (IPC_sMsg_t *) &(ring->ringBuf[tail]);
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Get the oldest record of the byte ring without removing it
+ * @param   ring        Byte ring
+ * @param   ppsMsg      Returns the oldest record
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE or E_IPC_ERR_RECV_FAIL if the ring is empty
+ */
+static IPC_eError_t IPC_ringPeek( IPC_sByteRing_t * ring, IPC_sMsg_t ** ppsMsg )
+{
+    uint32_t tail   = ring->ringTail;
+    uint32_t head   = ring->ringHead;
+
+    if (head == tail)  // Nothing to be received
+    {
+        return E_IPC_ERR_RECV_FAIL;
+    }
+
+    IPC_MEMORY_BARRIER(); // Don't read the record before the tail that published it
+    IPC_sMsg_t * psMsg = (IPC_sMsg_t *) &(ring->ringBuf[head]);
+    if (psMsg->u32DataLen == IPC_RING_WRAP_MARKER)  // Remaining bytes at the end are unused
+    {
+        head            = 0;
+        IPC_MEMORY_BARRIER();
+        ring->ringHead  = 0;
+        psMsg           = (IPC_sMsg_t *) ring->ringBuf;
+    }
+
+    *ppsMsg = psMsg;
+
+    uint32_t next = head + IPC_RING_RECORD_SIZE( psMsg->u32DataLen );
+    if (next != tail && !(next == ring->ringSize && tail == 0)) // There is more data in the queue to be received
+    {
+        return E_IPC_RECV_MORE;
+    }
+    else
+    {
+        return E_IPC_SUCCESS;
+    }
+}
+
+/**
+ * Remove the oldest record from the byte ring
+ * Must only be called after IPC_ringPeek() found a record.
+ * @param   ring        Byte ring
+ * @return  E_IPC_RECV_MORE if there are records left, else E_IPC_SUCCESS
+ */
+static IPC_eError_t IPC_ringRelease( IPC_sByteRing_t * ring )
+{
+    uint32_t head       = ring->ringHead;
+    IPC_sMsg_t * psMsg  = (IPC_sMsg_t *) &(ring->ringBuf[head]);
+
+    head += IPC_RING_RECORD_SIZE( psMsg->u32DataLen );
+    if (head == ring->ringSize)
+    {
+        head = 0;
+    }
+    IPC_MEMORY_BARRIER(); // The record has been read before the space is handed back
+    ring->ringHead = head;
+
+    if (head != ring->ringTail) // There is more data in the queue to be received
+    {
+        return E_IPC_RECV_MORE;
+    }
+    else  // All data has been received
+    {
+        return E_IPC_SUCCESS;
+    }
+}
+
+/**
+ * Get the credits of a sender
+ * Like IPC_ringReserve(), a record that doesn't fit in front of the buffer end
+ * may start over at the beginning.
+ * @param   psHandler   Receiver IPC handler
+ * @param   aType       Message type, selects the lane
+ * @return  free slots of the lane, for the byte ring the largest record size that fits
+ */
+static uint32_t IPC_credits( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType )
+{
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        const IPC_sByteRing_t * ring    = &(psHandler->ring);
+        uint32_t head                   = ring->ringHead;
+        uint32_t tail                   = ring->ringTail;
+
+        if (tail < head)
+        {
+            return head - tail - 1;
+        }
+        uint32_t toEnd = ring->ringSize - tail - ((head == 0) ? 1 : 0);    // Head and tail are only equal when empty
+        return (head > toEnd + 1) ? head - 1 : toEnd;
+    }
+
+    IPC_sMsgQueue_t * queue = IPC_typeQueue( psHandler, aType );
+    IPC_SHARED_FETCH( psHandler, queue );
+    uint32_t head   = queue->queueHead;
+    uint32_t count  = IPC_queueCount( queue, queue->queueTail, head );
+
+    return (count < queue->queueLength) ? queue->queueLength - count : 0;   // The head may be outdated already
+}
+
+/**
+ * Check if a sender can reserve its message
+ * @param   psHandler   Receiver IPC handler
+ * @param   aType       Message type, selects the lane
+ * @param   aNeed       Number of credits
+ * @param   aPoolLen    Payload size of the pool block it needs, 0 if none
+ * @return  true if the lane has aNeed credits and the pool a block that fits
+ */
+static uint32_t IPC_spaceReady( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType, uint32_t aNeed, uint32_t aPoolLen )
+{
+    if (IPC_credits( psHandler, aType ) < aNeed)
+    {
+        return 0;
+    }
+
+    for (uint32_t i = 0; aPoolLen != 0 && i < IPC_u8PoolClassCnt; i++)
+    {
+        if (aPoolLen <= IPC_arPoolClass[i].maxDataLen && (IPC_arPoolClass[i].freeHead & UINT16_MAX) != IPC_POOL_IDX_NONE)
+        {
+            return 1;
+        }
+    }
+    return (aPoolLen == 0);
+}
+
+/**
+ * Wait until a sender can reserve its message
+ * The sender registers in IPC_sWaitList and sleeps on IPC_WAIT_NOTIFY_INDEX
+ * until the receiver has made the space. If all IPC_WAITER_MAX entries are
+ * taken, or the kernel has no index for IPC_WAIT_NOTIFY_INDEX that isn't used
+ * by handlers, it falls back to checking once per tick.
+ * @param   psHandler       Receiver IPC handler
+ * @param   aType           Message type, selects the lane
+ * @param   aNeed           Number of credits
+ * @param   aPoolLen        Payload size of the pool block it needs, 0 if none
+ * @param   xTicksToWait    Max. time to wait
+ * @return  E_IPC_SUCCESS or E_IPC_ERR_QUEUE_FULL if the space didn't come back in time
+ */
+static IPC_eError_t IPC_spaceWait( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType, uint32_t aNeed, uint32_t aPoolLen,
+                                   TickType_t xTicksToWait )
+{
+    TimeOut_t xTimeOut;
+
+    vTaskSetTimeOutState( &xTimeOut );
+    while (!IPC_spaceReady( psHandler, aType, aNeed, aPoolLen ))
+    {
+        if (xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE) // Timed out
+        {
+            return E_IPC_ERR_QUEUE_FULL;
+        }
+        if (!IPC_WAIT_OWN_INDEX) // Sleeping on index 0 would take the count of the sender's own handler
+        {
+            vTaskDelay( 1 );
+            continue;
+        }
+
+        IPC_sWaiter_t * psWaiter = IPC_waitRegister( psHandler, aType, aNeed, aPoolLen );
+        if (psWaiter == NULL) // All entries are taken, let the receiver drain the queue
+        {
+            vTaskDelay( 1 );
+            continue;
+        }
+        /* The receiver either sees the registration or has made the space before this check */
+        IPC_MEMORY_BARRIER();
+        if (!IPC_spaceReady( psHandler, aType, aNeed, aPoolLen ))
+        {
+            (void) IPC_WAIT_TAKE( xTicksToWait );
+        }
+        IPC_waitUnregister( psHandler, psWaiter );
+    }
+
+    return E_IPC_SUCCESS;
+}
+
+/**
+ * Register the calling task as a sender waiting for space
+ * @param   psHandler   Receiver IPC handler
+ * @param   aType       Message type, selects the lane
+ * @param   aNeed       Number of credits
+ * @param   aPoolLen    Payload size of the pool block it needs, 0 if none
+ * @return  the entry, NULL if all entries are taken
+ */
+static IPC_sWaiter_t * IPC_waitRegister( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType, uint32_t aNeed, uint32_t aPoolLen )
+{
+    IPC_sWaitList_t * psList    = &IPC_sWaitList;
+    IPC_sWaiter_t * psWaiter    = NULL;
+    TaskHandle_t xSelf          = xTaskGetCurrentTaskHandle();
+
+    IPC_QUEUE_LOCK( psList );
+    for (uint32_t i = 0; i < IPC_WAITER_MAX; i++)
+    {
+        if (psList->entry[i].task == NULL)
+        {
+            psWaiter            = &(psList->entry[i]);
+            psWaiter->task      = xSelf;
+            psWaiter->handler   = psHandler;
+            psWaiter->type      = aType;
+            psWaiter->need      = aNeed;
+            psWaiter->poolLen   = aPoolLen;
+            if (aPoolLen != 0)
+            {
+                psList->poolCnt++;
+            }
+            else
+            {
+                psHandler->waiters++;
+            }
+            break;
+        }
+    }
+    IPC_QUEUE_UNLOCK( psList );
+
+    if (psWaiter != NULL)
+    {
+        IPC_SHARED_WAITING( psHandler, 1 );
+    }
+    return psWaiter;
+}
+
+/**
+ * Remove a waiting sender unless the receiver has already woken it
+ * @param   psHandler   Receiver IPC handler
+ * @param   psWaiter    Entry returned by IPC_waitRegister()
+ */
+static void IPC_waitUnregister( IPC_sHandler_t * psHandler, IPC_sWaiter_t * psWaiter )
+{
+    IPC_sWaitList_t * psList    = &IPC_sWaitList;
+    TaskHandle_t xSelf          = xTaskGetCurrentTaskHandle();
+
+    IPC_SHARED_WAITING( psHandler, 0 );
+    IPC_QUEUE_LOCK( psList );
+    if (psWaiter->task == xSelf && psWaiter->handler == psHandler) // Still registered, the receiver didn't wake this task
+    {
+        if (psWaiter->poolLen != 0)
+        {
+            psList->poolCnt--;
+        }
+        else
+        {
+            psHandler->waiters--;
+        }
+        psWaiter->task = NULL;
+    }
+    IPC_QUEUE_UNLOCK( psList );
+}
+
+/**
+ * Let waiting senders know that the receiver has made space
+ * Called by the receiver after it has moved the head. Without a waiting sender
+ * it costs a barrier and two loads.
+ * @param   psHandler   Receiver IPC handler
+ */
+static inline void IPC_spaceReturned( IPC_sHandler_t * psHandler )
+{
+    IPC_MEMORY_BARRIER(); // The new head is visible before the registrations are checked
+    IPC_SHARED_WAKE_SENDER( psHandler );
+    if (psHandler->waiters != 0 || IPC_sWaitList.poolCnt != 0)
+    {
+        IPC_wakeSenders( psHandler, NULL );
+    }
+}
+
+/**
+ * Wake the senders of a handler that have enough space now
+ * Senders waiting for a pool block are checked as well, the block may have come
+ * back from this handler.
+ * @param   psHandler   Receiver IPC handler
+ * @param   pxWoken     NULL in task context, else as for vTaskNotifyGiveFromISR()
+ */
+static void IPC_wakeSenders( IPC_sHandler_t * psHandler, BaseType_t * pxWoken )
+{
+    IPC_sWaitList_t * psList    = &IPC_sWaitList;
+    TaskHandle_t axTask[IPC_WAITER_MAX];
+    uint32_t cnt                = 0;
+
+    IPC_QUEUE_LOCK( psList );
+    for (uint32_t i = 0; i < IPC_WAITER_MAX; i++)
+    {
+        IPC_sWaiter_t * psWaiter = &(psList->entry[i]);
+        if (psWaiter->task == NULL || (psWaiter->handler != psHandler && psWaiter->poolLen == 0))
+        {
+            continue;
+        }
+        if (IPC_spaceReady( psWaiter->handler, psWaiter->type, psWaiter->need, psWaiter->poolLen ))
+        {
+            if (psWaiter->poolLen != 0)
+            {
+                psList->poolCnt--;
+            }
+            else
+            {
+                psHandler->waiters--;
+            }
+            axTask[cnt++]   = psWaiter->task;
+            psWaiter->task  = NULL;
+        }
+    }
+    IPC_QUEUE_UNLOCK( psList );
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        if (pxWoken != NULL)
+        {
+            IPC_WAIT_GIVE_FROM_ISR( axTask[i], pxWoken );
+        }
+        else
+        {
+            (void) IPC_WAIT_GIVE( axTask[i] );
+        }
+    }
+}
+
+/**
+ * Get the message a slot holds
+ * @param   psSlot      Message of a slot queue
+ * @return  the topic message the slot refers to, else the slot's own message
+ */
+static inline IPC_sMsg_t * IPC_slotMsg( IPC_sMsg_t * psSlot )
+{
+    IPC_sMsg_t * psRef = IPC_SLOT_HDR( psSlot )->ref;
+    return (psRef != NULL) ? psRef : psSlot;
+}
+
+/**
+ * Get the message that IPC_queueReserve() has reserved
+ * @param   psHandler   Receiver IPC handler
+ * @param   psMsg       The message returned by IPC_queueReserve()
+ * @return  the message the payload has to be written to
+ */
+static inline IPC_sMsg_t * IPC_queueData( const IPC_sHandler_t * psHandler, IPC_sMsg_t * psMsg )
+{
+    return (psHandler->kind == E_IPC_QUEUE_SLOTS) ? IPC_slotMsg( psMsg ) : psMsg;
+}
+
+/**
+ * Prepare a slot that has been read for reuse
+ * Drops the slot's reference to a topic message, if it holds one.
+ * @param   psSlot      Message of a slot queue
+ */
+static void IPC_slotClear( IPC_sMsg_t * psSlot )
+{
+    IPC_sSlotHdr_t * psHdr = IPC_SLOT_HDR( psSlot );
+
+    if (psHdr->ref != NULL)
+    {
+        IPC_blockUnref( psHdr->ref, 1 );
+        psHdr->ref = NULL;
+    }
+    if (psHdr->ready)   // Don't write the slot unless needed, a shared slot must stay clean in the receiver's cache
+    {
+        psHdr->ready = 0;
+    }
+}
+
+/**
+ * Drop references to a message block
+ * Receivers release their references concurrently, so the count is only
+ * changed by compare-and-swap. A pool block is freed with its last reference.
+ * @param   psMsg       Message of a topic or pool block
+ * @param   aCount      Number of references to drop
+ */
+static void IPC_blockUnref( IPC_sMsg_t * psMsg, uint32_t aCount )
+{
+    IPC_sBlockHdr_t * psHdr     = IPC_BLOCK_HDR( psMsg );
+    uint32_t refCnt;
+
+    IPC_MEMORY_BARRIER(); // The message has been read before the block can be reused
+    do
+    {
+        refCnt = psHdr->refCnt;
+    } while (!IPC_ATOMIC_CAS( &(psHdr->refCnt), refCnt, refCnt - aCount ));
+
+    if (refCnt == aCount && psHdr->poolClass != IPC_POOL_NONE) // That was the last reference
+    {
+        IPC_poolFree( psMsg );
+    }
+}
+
+/**
+ * Take a block from the smallest pool class it fits into
+ * If a class is exhausted, the next larger one is tried. The block is
+ * returned with one reference.
+ * @param   aDataSize   Size of message data in bytes
+ * @param   ppsMsg      Returns the block
+ * @return  E_IPC_SUCCESS, E_IPC_ERR_QUEUE_FULL or E_IPC_ERR_SEND_FAIL if no class is large enough
+ */
+static IPC_eError_t IPC_poolAlloc( uint32_t aDataSize, IPC_sMsg_t ** ppsMsg )
+{
+    IPC_eError_t error = E_IPC_ERR_SEND_FAIL;
+
+    for (uint32_t i = 0; i < IPC_u8PoolClassCnt; i++)
+    {
+        IPC_sPoolClass_t * pool = &IPC_arPoolClass[i];
+        if (aDataSize > pool->maxDataLen)
+        {
+            continue;
+        }
+
+        error = E_IPC_ERR_QUEUE_FULL;
+        uint32_t head;
+        IPC_sMsg_t * psBlock;
+        do
+        {
+            head = pool->freeHead;
+            if ((head & UINT16_MAX) == IPC_POOL_IDX_NONE) // This class is exhausted
+            {
+                break;
+            }
+            psBlock = IPC_BLOCK( pool, head & UINT16_MAX );
+        } while (!IPC_ATOMIC_CAS( &(pool->freeHead), head, IPC_POOL_HEAD( head, IPC_BLOCK_HDR( psBlock )->refCnt ) ));
+
+        if ((head & UINT16_MAX) != IPC_POOL_IDX_NONE)
+        {
+            IPC_BLOCK_HDR( psBlock )->refCnt = 1;
+            *ppsMsg = psBlock;
+            return E_IPC_SUCCESS;
+        }
+    }
+
+    return error;
+}
+
+/**
+ * Put a block back on the free list of its pool class
+ * @param   psMsg       Message of a pool block
+ */
+static void IPC_poolFree( IPC_sMsg_t * psMsg )
+{
+    IPC_sBlockHdr_t * psHdr     = IPC_BLOCK_HDR( psMsg );
+    IPC_sPoolClass_t * pool     = &IPC_arPoolClass[psHdr->poolClass];
+    uint32_t head;
+
+    do
+    {
+        head        = pool->freeHead;
+        psHdr->refCnt   = head & UINT16_MAX;
+        IPC_MEMORY_BARRIER(); // The link is written before the block is visible on the list
+    } while (!IPC_ATOMIC_CAS( &(pool->freeHead), head, IPC_POOL_HEAD( head, psHdr->blockIdx ) ));
+}
+
+/**
+ * Copy exactly aLen bytes of payload
+ * Both of the message buffers are word aligned, so the copy runs in 32 bit
+ * transfers (unrolled by four) whenever the caller's buffer is aligned as well.
+ * Trailing and unaligned bytes are copied one by one.
+ * @param   apDst     Destination buffer
+ * @param   apSrc     Source buffer
+ * @param   aLen      Number of bytes to copy
+ */
+static void IPC_copy( uint8_t * apDst, const uint8_t * apSrc, uint32_t aLen )
+{
+    if ((((uintptr_t) apDst | (uintptr_t) apSrc) & (sizeof(uint32_t) - 1)) == 0)
+    {
+        uint32_t * pu32Dst          = (uint32_t *) apDst;
+        const uint32_t * pu32Src    = (const uint32_t *) apSrc;
+
+        while (aLen >= 4 * sizeof(uint32_t))
+        {
+            pu32Dst[0] = pu32Src[0];
+            pu32Dst[1] = pu32Src[1];
+            pu32Dst[2] = pu32Src[2];
+            pu32Dst[3] = pu32Src[3];
+            pu32Dst += 4;
+            pu32Src += 4;
+            aLen    -= 4 * sizeof(uint32_t);
+        }
+        while (aLen >= sizeof(uint32_t))
+        {
+            *pu32Dst++  = *pu32Src++;
+            aLen       -= sizeof(uint32_t);
+        }
+
+        apDst = (uint8_t *) pu32Dst;
+        apSrc = (const uint8_t *) pu32Src;
+    }
+
+    while (aLen > 0)
+    {
+        *apDst++ = *apSrc++;
+        aLen--;
+    }
+}
+
+/**
+ * Send an IPC message to a handler
+ * @param   psHandler   Receiver IPC handler
+ * @param   aType       Message type
+ * @param   apData      Message data
+ * @param   aDataSize   Size of message data in bytes (<= IPC_MAX_DATA_LENGTH)
+ * @return  error
+ */
+static inline IPC_eError_t IPC_sendTo( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType, const uint8_t * apData, uint32_t aDataSize )
+{
+#if (IPC_USE_DMA == 1)
+    if (psHandler->dmaThreshold != 0 && aDataSize >= psHandler->dmaThreshold
+        && IPC_ATOMIC_CAS( &(psHandler->reserved), 0, 1 )) // Else a transfer is in flight and the CPU copies to the next slot
+    {
+        return IPC_sendDma( psHandler, aType, apData, aDataSize );
+    }
+#endif
+
+    IPC_sMsg_t * psMsg;
+    if (IPC_isTailReserved( psHandler )) // The next slot is reserved by IPC_sendReserve()
+    {
+        return E_IPC_ERR_SEND_FAIL;
+    }
+    IPC_eError_t error = IPC_queueReserveWait( psHandler, aType, aDataSize, &psMsg );
+    if (error != E_IPC_SUCCESS) // Queue is full or data too large
+    {
+        return error;
+    }
+
+    /* Copy data to message buffer */
+    IPC_COPY( IPC_queueData( psHandler, psMsg )->u8Data, apData, aDataSize );
+
+    IPC_queueCommit( psHandler, psMsg );
+    return IPC_notify( psHandler );
+}
+
+#if (IPC_USE_DMA == 1)
+/**
+ * Send an IPC message whose payload is copied by DMA
+ * The message stays reserved until the completion interrupt commits it with
+ * IPC_sendCommitFromISR(). If the transfer can't be started the CPU copies.
+ * The caller has already set psHandler->reserved.
+ * @param   psHandler   Receiver IPC handler
+ * @param   aType       Message type
+ * @param   apData      Message data, unchanged until the transfer is complete
+ * @param   aDataSize   Size of message data in bytes
+ * @return  error
+ */
+static IPC_eError_t IPC_sendDma( IPC_sHandler_t * psHandler, IPC_eMsgType_t aType, const uint8_t * apData, uint32_t aDataSize )
+{
+    IPC_sMsg_t * psMsg;
+    IPC_eError_t error = IPC_queueReserveWait( psHandler, aType, aDataSize, &psMsg );
+    if (error != E_IPC_SUCCESS) // Queue is full or data too large
+    {
+        psHandler->reserved = 0;
+        return error;
+    }
+
+    /*
+    * The DMA reads and writes memory. The source and the message header in
+    * front of the destination are written back first, so no dirty line can
+    * later be evicted over the payload.
+    */
+    IPC_sMsg_t * psData     = IPC_queueData( psHandler, psMsg );
+    psHandler->reservedMsg  = psMsg;
+    psHandler->dmaLen       = aDataSize;
+    IPC_cacheClean( apData, aDataSize );
+    IPC_cacheClean( psData, IPC_MSG_HDR_SIZE + aDataSize );
+
+    if (IPC_DMA_START( psData->u8Data, apData, aDataSize, psHandler->recvId ) == pdPASS)
+    {
+        return E_IPC_SUCCESS;   // Committed by the completion interrupt
+    }
+
+    psHandler->dmaLen = 0;
+    IPC_COPY( psData->u8Data, apData, aDataSize );
+    IPC_queueCommit( psHandler, psMsg );
+    psHandler->reserved = 0;
+    return IPC_notify( psHandler );
+}
+
+/**
+ * Finish the DMA transfer of the reserved message before it is committed
+ * Drops the lines the CPU may have fetched while the DMA was writing.
+ * @param   psHandler   Receiver IPC handler
+ */
+static void IPC_dmaDone( IPC_sHandler_t * psHandler )
+{
+    if (psHandler->dmaLen != 0)
+    {
+        IPC_cacheInvalidate( IPC_queueData( psHandler, psHandler->reservedMsg ), IPC_MSG_HDR_SIZE + psHandler->dmaLen );
+        psHandler->dmaLen = 0;
+    }
+}
+
+/**
+ * Check that the cache maintenance of a transfer stays inside its slot
+ * IPC_cacheInvalidate() works on whole lines, so every slot and pool block
+ * has to start on a cache line. IPC_SLOT_SIZE() is a multiple of the line.
+ * @param   psHandler   Receiver IPC handler
+ * @return  true if no line of a slot or block is shared with another one
+ */
+static uint32_t IPC_dmaAligned( const IPC_sHandler_t * psHandler )
+{
+    for (uint32_t l = 0; l < IPC_LANE_CNT; l++)
+    {
+        const IPC_sMsgQueue_t * queue = IPC_LANE( psHandler, l );
+        if (queue->queueLength != 0 && (((uintptr_t) queue->msgQueue | queue->slotSize) & (IPC_CACHE_LINE_SIZE - 1)) != 0)
+        {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < IPC_u8PoolClassCnt; i++)
+    {
+        if ((((uintptr_t) IPC_arPoolClass[i].storage | IPC_arPoolClass[i].slotSize) & (IPC_CACHE_LINE_SIZE - 1)) != 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+#endif
+
+#if (IPC_USE_MULTICORE == 1) || (IPC_USE_DMA == 1)
+/**
+ * Write the cache lines of a memory range back to memory
+ * @param   addr        Start of the range
+ * @param   len         Size of the range in bytes
+ */
+static void IPC_cacheClean( const volatile void * addr, uint32_t len )
+{
+    uintptr_t start = (uintptr_t) addr & ~(uintptr_t) (IPC_CACHE_LINE_SIZE - 1);
+    uintptr_t end   = ((uintptr_t) addr + len + IPC_CACHE_LINE_SIZE - 1) & ~(uintptr_t) (IPC_CACHE_LINE_SIZE - 1);
+    (void) start;
+    (void) end;
+    IPC_CACHE_CLEAN( start, end - start );
+}
+
+/**
+ * Drop the cache lines of a memory range, so the next read fetches what the other core or a DMA wrote
+ * @param   addr        Start of the range
+ * @param   len         Size of the range in bytes
+ */
+static void IPC_cacheInvalidate( const volatile void * addr, uint32_t len )
+{
+    uintptr_t start = (uintptr_t) addr & ~(uintptr_t) (IPC_CACHE_LINE_SIZE - 1);
+    uintptr_t end   = ((uintptr_t) addr + len + IPC_CACHE_LINE_SIZE - 1) & ~(uintptr_t) (IPC_CACHE_LINE_SIZE - 1);
+    (void) start;
+    (void) end;
+    IPC_CACHE_INVALIDATE( start, end - start );
+}
+#endif
+
+#if (IPC_USE_MULTICORE == 1)
+/**
+ * Fetch the index the other core writes to a shared queue
+ * The receiver's core reads the tail, the sender's core the head. Each index
+ * is on its own cache line, so this never drops a local write.
+ * @param   psHandler   IPC handler
+ * @param   queue       Shared queue
+ */
+static void IPC_sharedFetch( const IPC_sHandler_t * psHandler, const IPC_sMsgQueue_t * queue )
+{
+    if (psHandler->handle != NULL)
+    {
+        IPC_cacheInvalidate( &(queue->queueTail), sizeof(uint32_t) );
+    }
+    else
+    {
+        IPC_cacheInvalidate( &(queue->queueHead), sizeof(uint32_t) );
+    }
+}
+
+/**
+ * Write the index this core has changed back to the shared memory
+ * @param   psHandler   IPC handler
+ * @param   queue       Shared queue
+ */
+static void IPC_sharedPublish( const IPC_sHandler_t * psHandler, const IPC_sMsgQueue_t * queue )
+{
+    if (psHandler->handle != NULL)
+    {
+        IPC_cacheClean( &(queue->queueHead), sizeof(uint32_t) );
+    }
+    else
+    {
+        IPC_cacheClean( &(queue->queueTail), sizeof(uint32_t) );
+    }
+}
+
+/**
+ * Fetch a message the other core has written to a shared slot
+ * The headers come first, the payload is only fetched up to u32DataLen, but
+ * never beyond the slot.
+ * @param   queue       Shared queue
+ * @param   psSlot      Message of a shared slot
+ */
+static void IPC_sharedFetchMsg( const IPC_sMsgQueue_t * queue, IPC_sMsg_t * psSlot )
+{
+    IPC_cacheInvalidate( IPC_SLOT_HDR( psSlot ), IPC_SLOT_HDR_SIZE + IPC_MSG_HDR_SIZE );
+    uint32_t len = psSlot->u32DataLen;
+    IPC_cacheInvalidate( psSlot->u8Data, (len < queue->maxDataLen) ? len : queue->maxDataLen );
+}
+
+/**
+ * Write a message to the shared memory before it is committed
+ * @param   psSlot      Message of a shared slot
+ */
+static void IPC_sharedPublishMsg( IPC_sMsg_t * psSlot )
+{
+    IPC_cacheClean( IPC_SLOT_HDR( psSlot ), IPC_SLOT_HDR_SIZE + IPC_MSG_HDR_SIZE + psSlot->u32DataLen );
+}
+
+/**
+ * Tell the receiver's core that the sender waits for space
+ * Called on the sender's core, the flag is on the sender's cache line.
+ * @param   psHandler   Shared IPC handler
+ * @param   aWaiting    1 before the sender sleeps, 0 after it woke up
+ */
+static void IPC_sharedWaiting( const IPC_sHandler_t * psHandler, uint32_t aWaiting )
+{
+    IPC_sMsgQueue_t * queue = IPC_LANE( psHandler, 0 );
+    queue->senderWaiting    = aWaiting;
+    IPC_cacheClean( &(queue->queueTail), 2 * sizeof(uint32_t) );
+}
+
+/**
+ * Wake the sender's core if its sender waits for space
+ * Called on the receiver's core after the head has been published. The
+ * interrupt calls IPC_remoteNotifyFromISR() there, which wakes the sender.
+ * @param   psHandler   Shared IPC handler
+ */
+static void IPC_sharedWakeSender( const IPC_sHandler_t * psHandler )
+{
+    IPC_sMsgQueue_t * queue = IPC_LANE( psHandler, 0 );
+    IPC_cacheInvalidate( &(queue->queueTail), 2 * sizeof(uint32_t) );
+    if (queue->senderWaiting)
+    {
+        IPC_REMOTE_NOTIFY( psHandler->recvId );
+    }
+}
+#endif
+
+#if (IPC_USE_STATS == 1)
+/**
+ * Reset the counters of a handler
+ * @param   psHandler   IPC handler
+ */
+static void IPC_statsClear( IPC_sHandler_t * psHandler )
+{
+    IPC_sStatCnt_t * psCnt  = &(psHandler->stats);
+    psCnt->sent             = 0;
+    psCnt->dropped          = 0;
+    psCnt->rejected         = 0;
+    psCnt->highWater        = 0;
+    psCnt->received         = 0;
+    psCnt->latencyMin       = UINT32_MAX;
+    psCnt->latencyMax       = 0;
+    psCnt->latencySum       = 0;
+}
+
+/**
+ * Increment a sender side counter
+ * @param   pCounter    Counter of IPC_sStatCnt_t
+ */
+static void IPC_statsAdd( volatile uint32_t * pCounter )
+{
+    uint32_t value;
+    do
+    {
+        value = *pCounter;
+    } while (!IPC_ATOMIC_CAS( pCounter, value, value + 1 ));
+}
+
+/**
+ * Store the send time in a message that is about to be committed
+ * A block that is shared with other queues keeps the time it was published
+ * at, the other receivers may already be reading it.
+ * @param   psHandler   Receiver IPC handler
+ * @param   psMsg       The message returned by IPC_queueReserve()
+ */
+static void IPC_statsStamp( const IPC_sHandler_t * psHandler, IPC_sMsg_t * psMsg )
+{
+    IPC_sMsg_t * psData = IPC_queueData( psHandler, psMsg );
+
+    if (psData == psMsg || IPC_BLOCK_HDR( psData )->refCnt == 1)
+    {
+        psData->u32Timestamp = IPC_GET_TIMESTAMP();
+    }
+}
+
+/**
+ * Count a committed message and track the fill level of the queue
+ * @param   psHandler   Receiver IPC handler
+ */
+static void IPC_statsSent( IPC_sHandler_t * psHandler )
+{
+    uint32_t level;
+    uint32_t highWater;
+
+    if (psHandler->kind == E_IPC_QUEUE_RING)
+    {
+        uint32_t tail   = psHandler->ring.ringTail;
+        uint32_t head   = psHandler->ring.ringHead;
+        level           = (tail >= head) ? tail - head : psHandler->ring.ringSize - head + tail;
+    }
+    else if (psHandler->kind == E_IPC_QUEUE_MAILBOX)
+    {
+        level           = 1;
+    }
+    else
+    {
+        level           = IPC_slotCount( psHandler );
+    }
+
+    IPC_statsAdd( &(psHandler->stats.sent) );
+    do
+    {
+        highWater = psHandler->stats.highWater;
+    } while (level > highWater && !IPC_ATOMIC_CAS( &(psHandler->stats.highWater), highWater, level ));
+}
+
+/**
+ * Count a message the receiver is done with and record its latency
+ * @param   psHandler   Receiver IPC handler
+ * @param   psMsg       The received message
+ */
+static void IPC_statsReceived( IPC_sHandler_t * psHandler, const IPC_sMsg_t * psMsg )
+{
+    IPC_sStatCnt_t * psCnt  = &(psHandler->stats);
+    uint32_t latency        = IPC_GET_TIMESTAMP() - psMsg->u32Timestamp;     // Wraps correctly
+
+    psCnt->received++;
+    psCnt->latencySum      += latency;
+    if (latency < psCnt->latencyMin)
+    {
+        psCnt->latencyMin   = latency;
+    }
+    if (latency > psCnt->latencyMax)
+    {
+        psCnt->latencyMax   = latency;
+    }
+}
+#endif
+
+/**
+ * Get the IPC handler of a task ID
+ * The handler table is indexed by task ID, so this is a single load.
+ * @param   taskID    Receiver task ID
+ * @return  handler or NULL if there is no handler for this task ID
+ */
+static inline IPC_sHandler_t * IPC_getHandler( IPC_eTaskID_t taskID )
+{
+    if ((uint32_t) taskID >= IPC_TASK_ID_CNT)
+    {
+        return NULL;
+    }
+
+    return IPC_apHandlerLut[taskID];
+}
+
+/*******************************************************************************
+ * Init function
+ ******************************************************************************/
+/**
+ * Init IPC Handler module
+ */
+void IPC_initIPCHandler( void )
+{
+#if defined(IPC_TOPOLOGY)
+    /* The handlers are already set up at compile time, only the fields that aren't zero at runtime are left */
+    for (uint32_t i = 0; i < IPC_HANDLER_CNT_MAX; i++)
+    {
+#if (IPC_USE_MULTICORE == 1)
+        for (uint32_t l = 0; l < IPC_LANE_CNT; l++)
+        {
+            IPC_HANDLER_AT( i )->apLane[l] = &(IPC_HANDLER_AT( i )->lane[l]);
+        }
+#endif
+#if (IPC_USE_STATS == 1)
+        IPC_statsClear( IPC_HANDLER_AT( i ) );
+#endif
+    }
+#else
+    for (int i = 0; i < IPC_TASK_ID_CNT; i++)
+    {
+        IPC_apHandlerLut[i] = NULL;
+    }
+    IPC_u8HandlerCnt = 0;
+#if (configSUPPORT_DYNAMIC_ALLOCATION == 0)
+    IPC_u8DefaultStorageCnt = 0;
+#endif
+#endif
+
+    for (int i = 0; i < E_IPC_TOPIC_CNT; i++)
+    {
+        IPC_arTopic[i].pool = NULL;
+    }
+    IPC_u8PoolClassCnt = 0;
+    for (int i = 0; i < IPC_WAITER_MAX; i++)
+    {
+        IPC_sWaitList.entry[i].task = NULL;
+    }
+    IPC_sWaitList.poolCnt = 0;
+
+#if (IPC_USE_RPC == 1)
+    for (int i = 0; i < IPC_CALL_CNT_MAX; i++)
+    {
+        IPC_arCall[i].state = IPC_CALL_FREE;
+    }
+#endif
+
+#if (IPC_USE_STATS == 1)
+    IPC_TIMESTAMP_INIT();
+#endif
 }
 
 //EOF
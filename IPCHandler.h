@@ -9,6 +9,21 @@
  *          - Message format structure IPC_Msg_t
  *          - Wrapper functions for send and receive operations
  *          - Error numbers IPC_Error_t
+ *          - Zero-copy reserve/commit and peek/release operations
+ *          - Optional byte ring storage for variable length messages
+ *          - Mailbox handlers that only keep the latest message
+ *          - Publish/subscribe topics that share one copy of the payload
+ *          - Optional shared message pool with several block sizes
+ *          - Priority lanes that are received before the normal queue
+ *          - Dispatch of received messages to callbacks by message type
+ *          - Optional request/reply calls, the reply goes straight to the caller
+ *          - Credits for senders, which can wait until the receiver has made space
+ *          - Waiting for several handlers of one task with IPC_select()
+ *          - Optional per handler statistics with cycle counter latencies
+ *          - Optional handlers in shared memory for a receiver on another core
+ *          - Safe concurrent senders and receivers on FreeRTOS SMP kernels
+ *          - Optional DMA copy of large payloads by IPC_send()
+ *          - Optional static topology, handlers generated at compile time
  *
  * @detail  This IPC handler can be used in time-critical systems where FreeRTOS mechanisms
  *          like xQueue would take too much time to process incoming data. It is configurable
@@ -20,11 +35,20 @@
  *
  *          The handler can transmit data between tasks by sotring the data in a static
  *          buffer and informing the waiting task via direct task notification.
+ *          A notification only tells the receiver that there are messages. IPC_sendBatch(),
+ *          IPC_flush() and dropped messages give fewer notifications than messages, so
+ *          the receiver drains its queue until E_IPC_RECV_MORE ends instead of counting
+ *          notifications.
  *          
  *          Every task has got it's own handler. A task will
  *              - receive data from their own handler
  *              - send data to another task via the other task's handler.
  *
+ *          The functions that configure a handler, the message pool or a topic
+ *          (IPC_set...(), IPC_add...(), IPC_subscribe()) aren't synchronized with
+ *          senders and receivers. Call them before the first message is sent, i.e.
+ *          before the tasks that use the handler are started.
+ *
  * @author  Jasmin Curtz
  *
  * @version @v{ $Revision: 1.1 $ }
@@ -39,6 +63,7 @@
 /*********************
  *      INCLUDES
  *********************/
+#include <stddef.h>
 #include "FreeRTOS.h"
 #include "task.h"
 
@@ -46,7 +71,96 @@
  *      DEFINES
  *********************/
 #define IPC_MAX_DATA_LENGTH     512   /*!< The maximum data size that can be transmitted */
-#define IPC_MSG_QUEUE_LENGTH    16    /*!< The size of the message queues */
+#define IPC_MSG_QUEUE_LENGTH    16    /*!< The size of the message queues created by IPC_createHandler() */
+#define IPC_RING_ALIGN          8     /*!< Alignment of the records in a byte ring handler */
+#define IPC_BATCH_MAX           16    /*!< Max. number of messages IPC_receiveBatch() takes per call */
+#ifndef IPC_LANE_CNT
+#define IPC_LANE_CNT            2     /*!< Number of priority lanes a handler can have */
+#endif
+#ifndef IPC_CACHE_LINE_SIZE
+#define IPC_CACHE_LINE_SIZE     32    /*!< D-cache line size, a power of 2 >= sizeof(void *). Slots and queue indices are aligned to it */
+#endif
+#ifndef IPC_SECTION
+#define IPC_SECTION                   /*!< Section attribute of the handler tables, i.e. __attribute__(( section( ".dtcm" ) )) */
+#endif
+#ifndef IPC_USE_MULTICORE
+#define IPC_USE_MULTICORE       0     /*!< 1: Support handlers in memory shared with another core */
+#endif
+#ifndef IPC_USE_DMA
+#define IPC_USE_DMA             0     /*!< 1: IPC_send() can copy large payloads with IPC_DMA_START() */
+#endif
+#ifndef IPC_USE_SMP
+#if defined(configNUMBER_OF_CORES) && (configNUMBER_OF_CORES > 1)
+#define IPC_USE_SMP             1     /*!< 1: Senders and receivers run on several cores of a FreeRTOS SMP kernel */
+#else
+#define IPC_USE_SMP             0
+#endif
+#endif
+#ifndef IPC_USE_STATS
+#define IPC_USE_STATS           0     /*!< 1: Timestamp messages and keep the counters of IPC_getStats() */
+#endif
+#ifndef IPC_USE_RPC
+#define IPC_USE_RPC             0     /*!< 1: Support request/reply calls by IPC_call() and IPC_reply() */
+#endif
+
+/**
+* Number of senders, over all handlers, that can sleep in IPC_waitCredits() or
+* E_IPC_OVERFLOW_BLOCK until the receiver wakes them. Senders beyond it still
+* wait, but check for space once per tick, so raise it to the number of tasks
+* that block at the same time.
+*/
+#ifndef IPC_WAITER_MAX
+#define IPC_WAITER_MAX          4
+#endif
+
+#if defined(__GNUC__)
+#define IPC_ALIGNED( n )        __attribute__(( aligned( n ) ))
+#else
+#define IPC_ALIGNED( n )
+#endif
+
+/**
+* Attributes for handler, lane, topic and pool storage, so every slot starts on
+* a cache line and the storage can be placed next to the handler tables:
+* static uint8_t au8Queue[IPC_QUEUE_STORAGE_SIZE( 64, 16 )] IPC_STORAGE_ATTR;
+*/
+#define IPC_STORAGE_ATTR        IPC_SECTION IPC_ALIGNED( IPC_CACHE_LINE_SIZE )
+
+#define IPC_MSG_HDR_SIZE        offsetof( IPC_sMsg_t, u8Data )  /*!< Size of the message header in front of the payload */
+#define IPC_SLOT_HDR_SIZE       (2 * sizeof(void *))            /*!< Internal bookkeeping in front of every slot */
+
+/**
+* Bytes a message slot for payloads of up to aMaxLen bytes occupies, and the
+* storage IPC_createHandlerStatic() needs for aLength of these slots.
+* IPC_createTopic() uses the same layout for its message pool. Slots are
+* rounded to IPC_CACHE_LINE_SIZE, so a slot's header and the first bytes of its
+* payload share one cache line and neighbouring slots never share one.
+*/
+#define IPC_SLOT_SIZE( aMaxLen ) \
+    ((uint32_t) ((IPC_SLOT_HDR_SIZE + IPC_MSG_HDR_SIZE + (aMaxLen) + IPC_CACHE_LINE_SIZE - 1) & ~(IPC_CACHE_LINE_SIZE - 1)))
+#define IPC_QUEUE_STORAGE_SIZE( aLength, aMaxLen ) \
+    ((aLength) * IPC_SLOT_SIZE( aMaxLen ))
+
+/**
+* Bytes IPC_createSharedHandler() needs in the shared memory: the queue indices
+* followed by the slots.
+*/
+#define IPC_SHARED_HDR_SIZE     (4 * IPC_CACHE_LINE_SIZE)
+#define IPC_SHARED_STORAGE_SIZE( aLength, aMaxLen ) \
+    (IPC_SHARED_HDR_SIZE + IPC_QUEUE_STORAGE_SIZE( (aLength), (aMaxLen) ))
+
+/**
+* Bytes a message with aLen bytes of payload occupies in a byte ring handler.
+* Use it to size the buffer passed to IPC_createRingHandler().
+*/
+#define IPC_RING_RECORD_SIZE( aLen ) \
+    ((uint32_t) ((IPC_MSG_HDR_SIZE + (aLen) + IPC_RING_ALIGN - 1) & ~(IPC_RING_ALIGN - 1)))
+
+/**
+* Bytes IPC_createMailboxHandler() needs for its three buffers.
+*/
+#define IPC_MAILBOX_STORAGE_SIZE( aMaxLen ) \
+    (3 * IPC_SLOT_SIZE( aMaxLen ))
 
 /**********************
  *      TYPEDEFS
@@ -60,6 +174,7 @@ typedef enum
 {
     E_IPC_MSG_TYPE_1,
     E_IPC_MSG_TYPE_2,
+    E_IPC_MSG_TYPE_CNT,     /*!< Number of message types, must be the last entry */
 } IPC_eMsgType_t;
 
 /**
@@ -73,16 +188,76 @@ typedef enum
     E_IPC_TASK_ID_LAST      = UINT8_MAX,
 } IPC_eTaskID_t;
 
+/**
+* Optional static topology. If IPC_TOPOLOGY is defined, the handler table, the
+* queue storage and the task ID lookup table are generated at compile time, so
+* no IPC_createHandler() calls are needed. The table is fixed then, all create
+* functions return E_IPC_ERR_INVALID without allocating. One X( aTaskID, aQueueLength, aMaxDataLen, aPolicy, xTicksToWait )
+* per handler; each receiver is bound to its task with IPC_bindTask():
+*
+* #define IPC_TOPOLOGY( X ) \
+*     X( E_IPC_TASK_ID_1, 16, IPC_MAX_DATA_LENGTH, E_IPC_OVERFLOW_REJECT, 0 ) \
+*     X( E_IPC_TASK_ID_2, 4, 64, E_IPC_OVERFLOW_BLOCK, portMAX_DELAY )
+*
+* The table can also be kept in a header of its own named by IPC_TOPOLOGY_HEADER.
+* The handler table is initialized data then, so IPC_SECTION must be a section
+* the startup code copies. Every file that includes the topology can send with
+* IPC_SEND_STATIC( aTaskID, aType, apData, aDataSize ), which passes the
+* address of the handler as a link-time constant instead of looking up the task
+* ID. A task ID that isn't in the table doesn't compile.
+*/
+#if defined(IPC_TOPOLOGY_HEADER)
+#include IPC_TOPOLOGY_HEADER
+#endif
+struct IPC_sHandler_t;     /* Opaque, only its address is used outside of IPCHandler.c */
+#if defined(IPC_TOPOLOGY)
+#define IPC_TOPO_IDX( aTaskID, aLength, aMaxLen, aPolicy, xTicks )   IPC_TOPO_IDX_##aTaskID,
+#define IPC_TOPO_EXTERN( aTaskID, aLength, aMaxLen, aPolicy, xTicks ) \
+    extern struct IPC_sHandler_t IPC_sTopo_##aTaskID;
+enum { IPC_TOPOLOGY( IPC_TOPO_IDX ) IPC_TOPO_CNT };
+IPC_TOPOLOGY( IPC_TOPO_EXTERN )
+#define IPC_SEND_STATIC( aTaskID, aType, apData, aDataSize ) \
+    IPC_sendStatic( &IPC_sTopo_##aTaskID, (aType), (apData), (aDataSize) )
+#endif
+
+/**
+* Topics a message can be published to. Every task subscribed to a topic
+* receives a reference to the same copy of the message.
+*/
+typedef enum
+{
+    E_IPC_TOPIC_1,
+    E_IPC_TOPIC_CNT,    /*!< Number of topics, must be the last entry */
+} IPC_eTopicID_t;
+
 /**
 * This structure defines an IPC message header
+* The header is in front of the payload, so a message can be stored with only
+* u32DataLen bytes of payload (see IPC_createRingHandler()).
 */
 typedef struct IPC_Msg_t
 {
     IPC_eMsgType_t  eIPC_MsgType;                 /*!< The message/data type */
-    uint8_t         u8Data[IPC_MAX_DATA_LENGTH];  /*!< A data buffer storing all data as byte arrays */
     uint32_t        u32DataLen;                   /*!< The size of data being transmitted in bytes */ 
+#if (IPC_USE_STATS == 1)
+    uint32_t        u32Timestamp;                 /*!< IPC_GET_TIMESTAMP() when the message was sent */
+#endif
+#if (IPC_USE_RPC == 1)
+    uint32_t        u32CallID;                    /*!< Caller and sequence number of an IPC_call() request, 0 for other messages */
+#endif
+    uint8_t         u8Data[IPC_MAX_DATA_LENGTH];  /*!< A data buffer storing all data as byte arrays */
 } IPC_sMsg_t;
 
+/**
+* Describes one message of IPC_sendBatch()
+*/
+typedef struct
+{
+    IPC_eMsgType_t  eIPC_MsgType;   /*!< The message/data type */
+    const uint8_t * pu8Data;        /*!< Message data */
+    uint32_t        u32DataLen;     /*!< The size of data in bytes */
+} IPC_sBatchMsg_t;
+
 typedef enum
 {
     E_IPC_SUCCESS           = 0,  /*!< Operation was successful */
@@ -92,21 +267,178 @@ typedef enum
     E_IPC_ERR_SEND_FAIL     = 4,  /*!< Data could not be sent */
     E_IPC_ERR_RECV_FAIL     = 5,  /*!< Data could not be received */
     E_IPC_RECV_MORE         = 6,  /*!< Data has been successfully received, but there is more waiting in the queue */
+    E_IPC_ERR_INVALID       = 7,  /*!< Invalid parameter or operation not supported by this handler */
+    E_IPC_ERR_QUEUE_FULL    = 8,  /*!< Data could not be sent because the receiver's queue is full */
 } IPC_eError_t;
 
+/**
+* Counters of a handler returned by IPC_getStats() (IPC_USE_STATS only)
+* Latencies are the time from sending to receiving a message in
+* IPC_GET_TIMESTAMP() ticks, CPU cycles by default.
+*/
+typedef struct
+{
+    uint32_t        u32Sent;        /*!< Messages sent to the handler */
+    uint32_t        u32Received;    /*!< Messages received or released by the receiver */
+    uint32_t        u32Dropped;     /*!< Messages dropped by E_IPC_OVERFLOW_OVERWRITE */
+    uint32_t        u32Rejected;    /*!< Messages that could not be sent because the queue was full */
+    uint32_t        u32HighWater;   /*!< Max. number of queued messages, bytes for byte ring handlers */
+    uint32_t        u32LatencyMin;  /*!< Min. latency, UINT32_MAX if nothing has been received */
+    uint32_t        u32LatencyMax;  /*!< Max. latency */
+    uint32_t        u32LatencyAvg;  /*!< Average latency */
+} IPC_sStats_t;
+
+/**
+* Function IPC_dispatch() calls for a message
+* Gets the message type, the payload inside the queue and its size in bytes.
+*/
+typedef void (*IPC_pfnCallback_t)( IPC_eMsgType_t, const uint8_t *, uint32_t );
+
+/**
+* What IPC_send() does if the receiver's queue is full
+*/
+typedef enum
+{
+    E_IPC_OVERFLOW_REJECT       = 0,  /*!< Return E_IPC_ERR_QUEUE_FULL immediately (default) */
+    E_IPC_OVERFLOW_OVERWRITE    = 1,  /*!< Drop the oldest message, latest value wins */
+    E_IPC_OVERFLOW_BLOCK        = 2,  /*!< Wait up to a timeout for space (task context only) */
+} IPC_eOverflowPolicy_t;
+
+/**
+* How the queue of a handler is shared between senders
+*/
+typedef enum
+{
+    E_IPC_QUEUE_MODE_SPSC   = 0,  /*!< One sender, lock-free (default) */
+    E_IPC_QUEUE_MODE_MPSC   = 1,  /*!< Any number of senders (tasks and ISRs), lock-free slot claiming */
+} IPC_eQueueMode_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
 /**
  * Create an IPC handler
- * Each task can have max. one handler and each handler must be initialized by
- * an IPC_createHandler() call
+ * Each task ID can have max. one handler and each handler must be initialized by
+ * an IPC_createHandler() call. The queue has IPC_MSG_QUEUE_LENGTH slots of
+ * IPC_MAX_DATA_LENGTH bytes which are allocated from the FreeRTOS heap. If
+ * configSUPPORT_DYNAMIC_ALLOCATION is 0, they are taken from
+ * IPC_DEFAULT_STORAGE_CNT (2) queues in static memory instead, further
+ * handlers need IPC_createHandlerStatic().
  * @param   aRecv       Receiver task ID
  * @param   aHandle     Receiver task handle
  * @return  error
  */
 IPC_eError_t IPC_createHandler( IPC_eTaskID_t, TaskHandle_t );
 
+/**
+ * Create an IPC handler with caller provided storage
+ * Works like IPC_createHandler(), but queue depth and maximum payload size are
+ * chosen per handler and the storage is provided by the caller, the way
+ * xQueueCreateStatic() does it.
+ * @param   aRecv           Receiver task ID
+ * @param   aHandle         Receiver task handle
+ * @param   aQueueLength    Number of messages the queue can hold
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apStorage       Pointer aligned buffer of IPC_QUEUE_STORAGE_SIZE( aQueueLength, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_createHandlerStatic( IPC_eTaskID_t, TaskHandle_t, uint32_t, uint32_t, uint8_t * );
+
+/**
+ * Create an IPC handler that stores messages in a byte ring
+ * Messages occupy only IPC_RING_RECORD_SIZE( u32DataLen ) bytes instead of a
+ * whole IPC_sMsg_t, so capacity is measured in bytes and small messages are
+ * packed densely. The buffer is provided by the caller, so it can be placed
+ * in any memory region (i.e. DTCM).
+ * @param   aTaskID     Receiver task ID
+ * @param   aHandle     Receiver task handle
+ * @param   apBuf       Word aligned buffer for the records
+ * @param   aBufSize    Size of apBuf in bytes (multiple of IPC_RING_ALIGN)
+ * @return  error
+ */
+IPC_eError_t IPC_createRingHandler( IPC_eTaskID_t, TaskHandle_t, uint8_t *, uint32_t );
+
+/**
+ * Create an IPC handler that only keeps the latest message
+ * For state data where only the newest value matters. The handler is a
+ * lock-free triple buffer: sending never blocks or fails for a full queue, a
+ * newer message replaces the one that hasn't been received yet, and the
+ * receiver always gets the latest complete message. There is one sender per
+ * mailbox. Replaced messages are counted as dropped in IPC_getStats().
+ * @param   aTaskID         Receiver task ID
+ * @param   aHandle         Receiver task handle
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apStorage       Pointer aligned buffer of IPC_MAILBOX_STORAGE_SIZE( aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_createMailboxHandler( IPC_eTaskID_t, TaskHandle_t, uint32_t, uint8_t * );
+
+/**
+ * Create an IPC handler whose queue is in memory shared with another core
+ * Called on the receiver's core, the sender's core attaches to the same memory
+ * with IPC_attachSharedHandler(). The memory must have the same address on
+ * both cores. Cache lines are cleaned and invalidated with IPC_CACHE_CLEAN()
+ * and IPC_CACHE_INVALIDATE(), only for the bytes a message uses. The sender's
+ * core wakes the receiver with IPC_REMOTE_NOTIFY(), i.e. a Messaging Unit
+ * interrupt whose handler calls IPC_remoteNotifyFromISR(). A blocked sender is
+ * woken the same way from the receiver's core. Only one task of the sender's
+ * core may send to this handler, and it only supports the
+ * reject and block overflow policies, lane 0 and payloads up to aMaxDataLen.
+ * Only available if IPC_USE_MULTICORE is 1.
+ * @param   aTaskID         Receiver task ID
+ * @param   aHandle         Receiver task handle
+ * @param   aQueueLength    Number of messages the queue can hold
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apShared        IPC_CACHE_LINE_SIZE aligned buffer of IPC_SHARED_STORAGE_SIZE( aQueueLength, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_createSharedHandler( IPC_eTaskID_t, TaskHandle_t, uint32_t, uint32_t, uint8_t * );
+
+/**
+ * Attach to a handler another core has created by IPC_createSharedHandler()
+ * Called on the sender's core. Afterwards IPC_send() and the other send
+ * functions work with aTaskID like with a local handler.
+ * @param   aTaskID     Receiver task ID, the same as on the receiver's core
+ * @param   apShared    The buffer passed to IPC_createSharedHandler()
+ * @return  error, E_IPC_ERR_NO_HANDLER if the other core hasn't created the handler yet
+ */
+IPC_eError_t IPC_attachSharedHandler( IPC_eTaskID_t, uint8_t * );
+
+/**
+ * Wake the receiver or the waiting sender of a shared handler
+ * Call it from the interrupt that IPC_REMOTE_NOTIFY() raises. On the receiver's
+ * core it wakes the receiver, on the sender's core the sender that waits for
+ * space.
+ * @param   aTaskID                     Receiver task ID
+ * @param   pxHigherPriorityTaskWoken   Set to pdTRUE if the woken task should run on ISR exit (may be NULL)
+ * @return  error
+ */
+IPC_eError_t IPC_remoteNotifyFromISR( IPC_eTaskID_t, BaseType_t * );
+
+/**
+ * Set the receiver task of a handler of the static topology
+ * The handlers of IPC_TOPOLOGY exist before their tasks do, so each receiver
+ * has to be bound before it waits for messages. Messages sent before that are
+ * queued without a notification. Only available if IPC_TOPOLOGY is defined.
+ * @param   aTaskID     Receiver task ID
+ * @param   aHandle     Receiver task handle
+ * @return  error
+ */
+IPC_eError_t IPC_bindTask( IPC_eTaskID_t, TaskHandle_t );
+
+/**
+ * Add a block size to the message pool
+ * Payloads that don't fit into the slots of a handler are stored in a pool
+ * block and its slot only refers to the block, so a handler created with
+ * aMaxDataLen 0 holds nothing but references. The block goes back to the pool
+ * when the message has been received.
+ * @param   aMaxDataLen     The maximum data size of a block (<= IPC_MAX_DATA_LENGTH)
+ * @param   aBlockCnt       Number of blocks (< UINT16_MAX)
+ * @param   apStorage       Pointer aligned buffer of IPC_QUEUE_STORAGE_SIZE( aBlockCnt, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_addPoolClass( uint32_t, uint32_t, uint8_t * );
+
 /**
  * Send an IPC message
  * @param   aRecv       Receiver task ID
@@ -117,6 +449,260 @@ IPC_eError_t IPC_createHandler( IPC_eTaskID_t, TaskHandle_t );
  */
 IPC_eError_t IPC_send( IPC_eTaskID_t, IPC_eMsgType_t, uint8_t *, int );
 
+/**
+ * Send an IPC message to a handler of the static topology
+ * Works like IPC_send(), but takes the handler of IPC_TOPOLOGY itself, so
+ * there is no lookup. Use it through IPC_SEND_STATIC().
+ * Only available if IPC_TOPOLOGY is defined.
+ * @param   apHandler   IPC_sTopo_<aTaskID> of the receiver
+ * @param   aType       Message type
+ * @param   apData      Message data
+ * @param   aDataSize   Size of message data in bytes
+ * @return  error
+ */
+IPC_eError_t IPC_sendStatic( struct IPC_sHandler_t *, IPC_eMsgType_t, const uint8_t *, uint32_t );
+
+/**
+ * Send several IPC messages to the same receiver and notify it once
+ * The messages are queued in order until one of them fails. The receiver gets
+ * a single notification for the whole batch, so it has to drain its queue
+ * (E_IPC_RECV_MORE) instead of counting notifications.
+ * @param   aRecv       Receiver task ID
+ * @param   apMsgs      Array of aCount message descriptors
+ * @param   aCount      Number of messages
+ * @param   apSent      Returns the number of queued messages (may be NULL)
+ * @return  error of the first message that could not be sent, else E_IPC_SUCCESS
+ */
+IPC_eError_t IPC_sendBatch( IPC_eTaskID_t, const IPC_sBatchMsg_t *, uint32_t, uint32_t * );
+
+/**
+ * Send an IPC message without notifying the receiver
+ * The message is visible to the receiver right away, but it is only woken up
+ * by the next IPC_flush(). Use it to coalesce the notifications of a burst.
+ * The receiver gets one notification for all deferred messages.
+ * @param   aRecv       Receiver task ID
+ * @param   aType       Message type
+ * @param   apData      Message data
+ * @param   aDataSize   Size of message data in bytes
+ * @return  error
+ */
+IPC_eError_t IPC_sendDeferred( IPC_eTaskID_t, IPC_eMsgType_t, const uint8_t *, uint32_t );
+
+/**
+ * Notify the receiver about messages sent by IPC_sendDeferred()
+ * Gives a single notification however many messages are pending, does nothing
+ * if none is.
+ * @param   aRecv       Receiver task ID
+ * @return  error
+ */
+IPC_eError_t IPC_flush( IPC_eTaskID_t );
+
+/**
+ * Reserve the next free slot of the receiver's queue
+ * The payload can be written directly to the returned buffer. The message is
+ * not visible to the receiver until IPC_sendCommit() is called. There can be
+ * max. one open reservation per receiver.
+ * @param   aRecv       Receiver task ID
+ * @param   aType       Message type
+ * @param   aDataSize   Size of message data in bytes
+ * @param   appData     Returns a pointer to the payload buffer inside the queue
+ * @return  error
+ */
+IPC_eError_t IPC_sendReserve( IPC_eTaskID_t, IPC_eMsgType_t, uint32_t, uint8_t ** );
+
+/**
+ * Publish the slot reserved by IPC_sendReserve() and notify the receiver
+ * @param   aRecv       Receiver task ID
+ * @return  error
+ */
+IPC_eError_t IPC_sendCommit( IPC_eTaskID_t );
+
+/**
+ * Send an IPC message from an interrupt service routine
+ * Works like IPC_send(), but notifies the receiver with vTaskNotifyGiveIndexedFromISR().
+ * Unless the receiver's queue is in E_IPC_QUEUE_MODE_MPSC, don't send to the
+ * same receiver from an ISR and from a task.
+ * @param   aRecv                       Receiver task ID
+ * @param   aType                       Message type
+ * @param   apData                      Message data
+ * @param   aDataSize                   Size of message data in bytes
+ * @param   pxHigherPriorityTaskWoken   Set to pdTRUE if the receiver should run on ISR exit (may be NULL)
+ * @return  error
+ */
+IPC_eError_t IPC_sendFromISR( IPC_eTaskID_t, IPC_eMsgType_t, const uint8_t *, uint32_t, BaseType_t * );
+
+/**
+ * Publish the slot reserved by IPC_sendReserve() from an interrupt service routine
+ * Lets a DMA completion interrupt hand over a buffer that was filled in place.
+ * @param   aRecv                       Receiver task ID
+ * @param   pxHigherPriorityTaskWoken   Set to pdTRUE if the receiver should run on ISR exit (may be NULL)
+ * @return  error
+ */
+IPC_eError_t IPC_sendCommitFromISR( IPC_eTaskID_t, BaseType_t * );
+
+/**
+ * Select how the queue of a handler is shared between senders
+ * In E_IPC_QUEUE_MODE_MPSC senders claim a slot with a compare-and-swap and copy
+ * their payload outside of any critical section. Only slot queues support
+ * this mode.
+ * @param   aTaskID     Receiver task ID
+ * @param   aMode       E_IPC_QUEUE_MODE_SPSC or E_IPC_QUEUE_MODE_MPSC
+ * @return  error
+ */
+IPC_eError_t IPC_setQueueMode( IPC_eTaskID_t, IPC_eQueueMode_t );
+
+/**
+ * Select what happens if a message is sent to a full queue
+ * E_IPC_OVERFLOW_OVERWRITE is only supported for slot queues with a single
+ * sender; a message the receiver is currently reading is never dropped.
+ * IPC_sendFromISR() never blocks and treats E_IPC_OVERFLOW_BLOCK as reject.
+ * With E_IPC_OVERFLOW_BLOCK the sender waits like in IPC_waitCredits().
+ * @param   aTaskID         Receiver task ID
+ * @param   aPolicy         Overflow policy
+ * @param   xTicksToWait    Max. time IPC_send() waits for space (E_IPC_OVERFLOW_BLOCK only)
+ * @return  error
+ */
+IPC_eError_t IPC_setOverflowPolicy( IPC_eTaskID_t, IPC_eOverflowPolicy_t, TickType_t );
+
+/**
+ * Get the credits of a sender, the space left in the queue of a message type
+ * Every message the receiver takes out of the queue gives a credit back. The
+ * count is taken from the queue indices without a kernel call, so it can be
+ * checked before every send. Not supported by mailbox handlers, which are
+ * never full.
+ * @param   aRecv       Receiver task ID
+ * @param   aType       Message type, selects the lane
+ * @param   apCredits   Returns the number of free slots, for byte ring handlers
+ *                      the largest IPC_RING_RECORD_SIZE() that fits
+ * @return  error
+ */
+IPC_eError_t IPC_getCredits( IPC_eTaskID_t, IPC_eMsgType_t, uint32_t * );
+
+/**
+ * Wait until the queue of a message type has at least aCredits credits
+ * The receiver wakes the sender on IPC_WAIT_NOTIFY_INDEX as soon as it has
+ * released enough messages. If more than IPC_WAITER_MAX senders wait at once,
+ * the others check the credits once per tick. So does every sender if the
+ * kernel has a single notification index, which all handlers use. Must be
+ * called by a task.
+ * @param   aRecv           Receiver task ID
+ * @param   aType           Message type, selects the lane
+ * @param   aCredits        Number of credits to wait for (see IPC_getCredits())
+ * @param   xTicksToWait    Max. time to wait
+ * @return  error, E_IPC_ERR_QUEUE_FULL if the credits didn't come back in time
+ */
+IPC_eError_t IPC_waitCredits( IPC_eTaskID_t, IPC_eMsgType_t, uint32_t, TickType_t );
+
+/**
+ * Let IPC_send() copy large payloads to this handler by DMA
+ * IPC_send() reserves the slot, starts IPC_DMA_START() and returns without
+ * waiting for the copy. The transfer's completion interrupt publishes the
+ * message with IPC_sendCommitFromISR(). Until then apData must not change.
+ * Sends during a transfer take the next slot and copy by CPU, the receiver
+ * still gets the messages in order. Needs E_IPC_QUEUE_MODE_MPSC, and every
+ * lane and pool class must start on a cache line, so add them first.
+ * Only available if IPC_USE_DMA is 1.
+ * @param   aTaskID     Receiver task ID
+ * @param   aThreshold  Min. payload size in bytes IPC_send() copies by DMA, 0 to always copy by CPU
+ * @return  error, E_IPC_ERR_INVALID if the queue isn't MPSC or not cache line aligned
+ */
+IPC_eError_t IPC_setDmaThreshold( IPC_eTaskID_t, uint32_t );
+
+/**
+ * Select the task notification index a handler notifies its receiver on
+ * Keeps IPC notifications apart from those the task uses for other events, i.e.
+ * DMA or timers. The default is IPC_NOTIFY_INDEX (0).
+ * @param   aTaskID     Receiver task ID
+ * @param   uxIndex     Notification index (< configTASK_NOTIFICATION_ARRAY_ENTRIES, not IPC_WAIT_NOTIFY_INDEX)
+ * @return  error
+ */
+IPC_eError_t IPC_setNotifyIndex( IPC_eTaskID_t, UBaseType_t );
+
+/**
+ * Add a handler to the select group of its receiver task
+ * A task can own several handlers (one per task ID) and wait for all of them
+ * with IPC_select(). The handler then notifies the task by setting its select
+ * bit instead of incrementing the notification count. All handlers of a task's
+ * select group must use the same notification index, which should not be used
+ * for anything else.
+ * @param   aTaskID     Receiver task ID
+ * @param   aBit        Select bit of the handler (0 .. 31)
+ * @return  error
+ */
+IPC_eError_t IPC_setSelectBit( IPC_eTaskID_t, uint32_t );
+
+/**
+ * Wait until at least one handler of the calling task's select group has a message
+ * The queues are checked first, so there is no kernel call if a message is
+ * already waiting. A set bit only means the handler has a message at the time
+ * of the check, receive until the handler is empty before selecting again.
+ * @param   aBits           Select bits of the handlers to wait for
+ * @param   apReady         Returns the select bits of the handlers with messages
+ * @param   xTicksToWait    Max. time to wait for a message
+ * @return  error, E_IPC_ERR_RECV_FAIL if no message arrived in time
+ */
+IPC_eError_t IPC_select( uint32_t, uint32_t *, TickType_t );
+
+/**
+ * Add a priority lane to a handler
+ * The messages of a lane are received before those of all lower lanes. Lane 0
+ * is the queue the handler has been created with.
+ * @param   aTaskID         Receiver task ID
+ * @param   aLane           Lane number (1 .. IPC_LANE_CNT - 1)
+ * @param   aQueueLength    Number of messages the lane can hold
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apStorage       Pointer aligned buffer of IPC_QUEUE_STORAGE_SIZE( aQueueLength, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_addLane( IPC_eTaskID_t, uint32_t, uint32_t, uint32_t, uint8_t * );
+
+/**
+ * Select the lane messages of a type are sent to
+ * All types are sent to lane 0 by default.
+ * @param   aTaskID     Receiver task ID
+ * @param   aType       Message type
+ * @param   aLane       Lane number, the lane must have been added by IPC_addLane()
+ * @return  error
+ */
+IPC_eError_t IPC_setTypeLane( IPC_eTaskID_t, IPC_eMsgType_t, uint32_t );
+
+/**
+ * Create a topic with caller provided storage for its messages
+ * A published message is stored once in the topic's pool and stays there until
+ * every subscriber has received or released it.
+ * @param   aTopic          Topic ID
+ * @param   aPoolLength     Number of messages that can be in flight at the same time
+ * @param   aMaxDataLen     The maximum data size of a message (<= IPC_MAX_DATA_LENGTH)
+ * @param   apStorage       Pointer aligned buffer of IPC_QUEUE_STORAGE_SIZE( aPoolLength, aMaxDataLen ) bytes
+ * @return  error
+ */
+IPC_eError_t IPC_createTopic( IPC_eTopicID_t, uint32_t, uint32_t, uint8_t * );
+
+/**
+ * Subscribe the handler of a task to a topic
+ * Only slot queue handlers can subscribe. The publisher counts as a sender to
+ * the subscriber's queue, so use E_IPC_QUEUE_MODE_MPSC if the subscriber
+ * receives from other senders as well.
+ * @param   aTopic      Topic ID
+ * @param   aTaskID     Subscriber task ID
+ * @return  error
+ */
+IPC_eError_t IPC_subscribe( IPC_eTopicID_t, IPC_eTaskID_t );
+
+/**
+ * Publish an IPC message to all subscribers of a topic
+ * The payload is copied once, each subscriber's queue only gets a reference.
+ * Subscribers receive it like any other message. A subscriber with a full queue
+ * misses the message, the others still get it. Only one task may publish to a
+ * topic.
+ * @param   aTopic      Topic ID
+ * @param   aType       Message type
+ * @param   apData      Message data
+ * @param   aDataSize   Size of message data in bytes
+ * @return  error, E_IPC_ERR_QUEUE_FULL if the pool or a subscriber's queue was full
+ */
+IPC_eError_t IPC_publish( IPC_eTopicID_t, IPC_eMsgType_t, const uint8_t *, uint32_t );
+
 /**
  * Receive an IPC message
  * @param   aRecv    Receiver task ID
@@ -125,6 +711,158 @@ IPC_eError_t IPC_send( IPC_eTaskID_t, IPC_eMsgType_t, uint8_t *, int );
  */
 IPC_eError_t IPC_receive( IPC_eTaskID_t, IPC_sMsg_t * );
 
+/**
+ * Receive an IPC message, wait for one if the queue is empty
+ * If a message is waiting, it is received without a kernel call. Otherwise the
+ * receiver task blocks on its notification until a message arrives or the
+ * timeout expires. Notifications of messages that have already been received
+ * only cause another check of the queue. Must only be called by the receiver
+ * task.
+ * @param   aRecv           Receiver task ID
+ * @param   apBuf           Message buffer
+ * @param   xTicksToWait    Max. time to wait for a message
+ * @return  error, E_IPC_ERR_RECV_FAIL if no message arrived in time
+ */
+IPC_eError_t IPC_receiveWait( IPC_eTaskID_t, IPC_sMsg_t *, TickType_t );
+
+/**
+ * Borrow the oldest IPC message without copying it
+ * The returned slot stays valid and will not be overwritten by IPC_send() until
+ * it is handed back by IPC_receiveRelease(). Only one message can be borrowed
+ * per handler at a time. Don't access the payload beyond u32DataLen.
+ * @param   aRecv       Receiver task ID
+ * @param   appMsg      Returns a pointer to the message inside the queue
+ * @return  error
+ */
+IPC_eError_t IPC_receivePeek( IPC_eTaskID_t, const IPC_sMsg_t ** );
+
+/**
+ * Release the message borrowed by IPC_receivePeek()
+ * @param   aRecv       Receiver task ID
+ * @return  error
+ */
+IPC_eError_t IPC_receiveRelease( IPC_eTaskID_t );
+
+/**
+ * Forward the oldest message of a handler to another task
+ * Receives the message from aRecvFrom and sends it to aSendTo as aType. A
+ * message that is stored in a pool or topic block is handed over by reference,
+ * so the payload isn't copied. It is copied once if it is stored in the slot
+ * itself, if the block is shared with other receivers and the type changes or
+ * if aSendTo is a byte ring handler. If it can't be sent, the message stays in
+ * aRecvFrom's queue.
+ * @param   aRecvFrom   Task ID of the handler to take the message from
+ * @param   aSendTo     Receiver task ID
+ * @param   aType       Message type of the forwarded message
+ * @return  error, E_IPC_RECV_MORE if there are more messages for aRecvFrom
+ */
+IPC_eError_t IPC_forward( IPC_eTaskID_t, IPC_eTaskID_t, IPC_eMsgType_t );
+
+/**
+ * Receive up to aMaxCount IPC messages in one call
+ * Drains the queue in one pass and hands the slots back at once. At most
+ * IPC_BATCH_MAX messages are received per call.
+ * @param   aRecv       Receiver task ID
+ * @param   apBufs      Array of aMaxCount message buffers
+ * @param   aMaxCount   Max. number of messages to receive
+ * @param   apReceived  Returns the number of received messages
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE if messages are left or E_IPC_ERR_RECV_FAIL if there was none
+ */
+IPC_eError_t IPC_receiveBatch( IPC_eTaskID_t, IPC_sMsg_t *, uint32_t, uint32_t * );
+
+/**
+ * Borrow up to aMaxCount IPC messages without copying them
+ * Works like IPC_receivePeek() for several messages. The pointers refer to
+ * consecutive messages of the queue, the ring wrap is already accounted for.
+ * Hand them back with IPC_receiveReleaseBatch().
+ * @param   aRecv       Receiver task ID
+ * @param   appMsgs     Array of aMaxCount message pointers
+ * @param   aMaxCount   Max. number of messages to borrow
+ * @param   apCount     Returns the number of borrowed messages
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE if messages are left or E_IPC_ERR_RECV_FAIL if there was none
+ */
+IPC_eError_t IPC_receivePeekBatch( IPC_eTaskID_t, const IPC_sMsg_t **, uint32_t, uint32_t * );
+
+/**
+ * Release messages borrowed by IPC_receivePeekBatch()
+ * A count larger than the number of messages in the queue is clamped, so
+ * messages a sender is still writing are never released.
+ * @param   aRecv       Receiver task ID
+ * @param   aCount      Number of messages to release (the count returned by IPC_receivePeekBatch())
+ * @return  error
+ */
+IPC_eError_t IPC_receiveReleaseBatch( IPC_eTaskID_t, uint32_t );
+
+/**
+ * Register the function IPC_dispatch() calls for messages of a type
+ * @param   aTaskID         Receiver task ID
+ * @param   aType           Message type
+ * @param   apfnCallback    Callback, NULL to remove it
+ * @return  error
+ */
+IPC_eError_t IPC_registerCallback( IPC_eTaskID_t, IPC_eMsgType_t, IPC_pfnCallback_t );
+
+/**
+ * Receive up to aMaxCount IPC messages and pass each to the callback of its type
+ * The callback gets a pointer to the payload inside the queue, so the message
+ * isn't copied. The payload is only valid until the callback returns. Messages
+ * of a type without a callback are dropped. Must only be called by the
+ * receiver task.
+ * @param   aTaskID     Receiver task ID
+ * @param   aMaxCount   Max. number of messages to dispatch
+ * @return  E_IPC_SUCCESS, E_IPC_RECV_MORE if messages are left or E_IPC_ERR_RECV_FAIL if there was none
+ */
+IPC_eError_t IPC_dispatch( IPC_eTaskID_t, uint32_t );
+
+/**
+ * Send a request and wait for its reply
+ * The request is queued like by IPC_send() with a call ID in its header. The
+ * receiver answers it with IPC_reply(), which writes the reply directly into
+ * apResp and wakes the caller on IPC_WAIT_NOTIFY_INDEX, so the reply never
+ * goes through a queue and the caller doesn't need a handler of its own. A
+ * reply that comes after the timeout is discarded. Must be called by a task.
+ * Only available if IPC_USE_RPC is 1, which needs at least two notification
+ * indices (configTASK_NOTIFICATION_ARRAY_ENTRIES >= 2).
+ * @param   aRecv           Receiver task ID
+ * @param   aType           Message type of the request
+ * @param   apReq           Request data
+ * @param   aReqSize        Size of request data in bytes
+ * @param   apResp          Returns the reply
+ * @param   xTicksToWait    Max. time to wait for the reply
+ * @return  error, E_IPC_ERR_RECV_FAIL if no reply arrived in time
+ */
+IPC_eError_t IPC_call( IPC_eTaskID_t, IPC_eMsgType_t, const uint8_t *, uint32_t, IPC_sMsg_t *, TickType_t );
+
+/**
+ * Answer a request sent by IPC_call()
+ * Can be called with the received copy or the borrowed message of the request.
+ * IPC_forward() keeps the call ID, so the task a request is forwarded to can
+ * answer it.
+ * @param   apReq       The request
+ * @param   aType       Message type of the reply
+ * @param   apData      Reply data
+ * @param   aDataSize   Size of reply data in bytes
+ * @return  error, E_IPC_ERR_INVALID if apReq isn't a request, E_IPC_ERR_SEND_FAIL if the caller stopped waiting
+ */
+IPC_eError_t IPC_reply( const IPC_sMsg_t *, IPC_eMsgType_t, const uint8_t *, uint32_t );
+
+/**
+ * Get the counters of a handler
+ * Only available if IPC_USE_STATS is 1. The counters are updated without
+ * locking, so they may be off by the messages in flight while they are read.
+ * @param   aTaskID     Receiver task ID
+ * @param   apStats     Returns the counters
+ * @return  error, E_IPC_ERR_INVALID if the statistics are disabled
+ */
+IPC_eError_t IPC_getStats( IPC_eTaskID_t, IPC_sStats_t * );
+
+/**
+ * Reset the counters of a handler
+ * @param   aTaskID     Receiver task ID
+ * @return  error, E_IPC_ERR_INVALID if the statistics are disabled
+ */
+IPC_eError_t IPC_resetStats( IPC_eTaskID_t );
+
 /**
  * Init IPC Handler module
  */
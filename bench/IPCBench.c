@@ -0,0 +1,407 @@
+/*
+ * This IPCBench.c measures the IPCHandler against FreeRTOS queues and message
+ * buffers on the host, using the FreeRTOS POSIX port. See README.md for the
+ * build command.
+ *
+ * For every payload size and queue depth it measures
+ *  - send:     ns per message to fill an empty queue from one task
+ *  - receive:  ns per message to drain the full queue in the same task
+ *  - pingpong: ns per round trip between two tasks, one message each way
+ *
+ * Times are wall clock times of the host (CLOCK_MONOTONIC), so they include
+ * the POSIX port's context switches. Compare the implementations with each
+ * other on the same machine, not with numbers taken on the target.
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "message_buffer.h"
+
+#include "IPCHandler.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_MSG_CNT           100000  /*!< Messages per measurement */
+#define BENCH_PINGPONG_CNT      20000   /*!< Round trips per measurement */
+#define BENCH_DEPTH_MAX         64      /*!< Largest queue depth measured */
+#define BENCH_TASK_ID_BASE      10      /*!< First task ID the benchmark creates handlers for */
+#define BENCH_PRIO_MASTER       ( tskIDLE_PRIORITY + 2 )
+#define BENCH_PRIO_ECHO         ( tskIDLE_PRIORITY + 1 )
+#define BENCH_NOTIFY_INDEX      1       /*!< Notification index of the IPC handlers, index 0 signals the end of an echo task */
+
+#define BENCH_CHECK( x )        do { if (!(x)) vAssertCalled( __FILE__, __LINE__ ); } while (0)  /*!< Also evaluated if configASSERT() is disabled */
+
+/**
+* The implementations that are measured
+*/
+typedef enum
+{
+    E_BENCH_IPC,        /*!< IPC_send() / IPC_receive() */
+    E_BENCH_IPC_ZC,     /*!< IPC_sendReserve() / IPC_sendCommit() and IPC_receivePeek() / IPC_receiveRelease() */
+    E_BENCH_QUEUE,      /*!< xQueueSend() / xQueueReceive() */
+    E_BENCH_MSGBUF,     /*!< xMessageBufferSend() / xMessageBufferReceive() */
+    E_BENCH_IMPL_CNT,
+} BENCH_eImpl_t;
+
+/**
+* The channel of one measurement, only the members of its implementation are used
+*/
+typedef struct
+{
+    BENCH_eImpl_t           impl;
+    uint32_t                size;       /*!< Payload size in bytes */
+    IPC_eTaskID_t           ipcId;      /*!< Receiver handler */
+    QueueHandle_t           queue;
+    MessageBufferHandle_t   msgBuf;
+} BENCH_sChannel_t;
+
+/**
+* Parameters of the echo task of a ping-pong measurement
+*/
+typedef struct
+{
+    BENCH_sChannel_t        request;    /*!< Master to echo task */
+    BENCH_sChannel_t        reply;      /*!< Echo task to master */
+    TaskHandle_t            master;
+} BENCH_sPingPong_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+void vAssertCalled( const char * pcFile, unsigned long ulLine );
+
+static void bench_task( void * param );
+static void bench_echoTask( void * param );
+static void bench_throughput( BENCH_eImpl_t, uint32_t, uint32_t );
+static void bench_pingPong( BENCH_eImpl_t, uint32_t );
+static void bench_open( BENCH_sChannel_t *, BENCH_eImpl_t, uint32_t, uint32_t, TaskHandle_t );
+static void bench_close( BENCH_sChannel_t * );
+static void bench_send( BENCH_sChannel_t *, const uint8_t * );
+static void bench_receive( BENCH_sChannel_t *, uint8_t *, TickType_t );
+static uint64_t bench_now( void );
+static void bench_print( const char *, BENCH_eImpl_t, uint32_t, uint32_t, uint64_t, uint32_t );
+
+/*******************************************************************************
+ * Globals
+ ******************************************************************************/
+static const uint32_t bench_au32Size[]      = { 4, 16, 64, 128, 512 };
+static const uint32_t bench_au32Depth[]     = { 4, 16, BENCH_DEPTH_MAX };
+static const char * const bench_apcImpl[]   = { "ipc", "ipc-zc", "queue", "msgbuf" };
+
+/* Handlers can't be deleted, so every channel gets a new task ID and reuses the storage */
+static uint8_t bench_au8Storage[2][IPC_QUEUE_STORAGE_SIZE( BENCH_DEPTH_MAX, IPC_MAX_DATA_LENGTH )]
+    IPC_STORAGE_ATTR;
+static uint32_t bench_u32NextId = BENCH_TASK_ID_BASE;
+
+static IPC_sMsg_t bench_sMsgBuff;   /*!< Receive buffer of IPC_receive() */
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/*!
+ * @brief Main function
+ */
+int main( void )
+{
+    IPC_initIPCHandler();
+
+    if (pdPASS != xTaskCreate( bench_task, "bench", configMINIMAL_STACK_SIZE * 4, NULL, BENCH_PRIO_MASTER, NULL ))
+    {
+        printf( "Task creation failed!\n" );
+        return 1;
+    }
+
+    vTaskStartScheduler();
+    return 0;
+}
+
+/**
+ * Run all measurements and end the process
+ */
+static void bench_task( void * param )
+{
+    (void) param;
+
+    printf( "%-9s %-7s %5s %5s %10s %12s\n", "test", "impl", "size", "depth", "ns/msg", "msg/s" );
+    for (uint32_t d = 0; d < sizeof( bench_au32Depth ) / sizeof( bench_au32Depth[0] ); d++)
+    {
+        for (uint32_t s = 0; s < sizeof( bench_au32Size ) / sizeof( bench_au32Size[0] ); s++)
+        {
+            for (uint32_t i = 0; i < E_BENCH_IMPL_CNT; i++)
+            {
+                bench_throughput( (BENCH_eImpl_t) i, bench_au32Size[s], bench_au32Depth[d] );
+            }
+        }
+    }
+
+    for (uint32_t s = 0; s < sizeof( bench_au32Size ) / sizeof( bench_au32Size[0] ); s++)
+    {
+        for (uint32_t i = 0; i < E_BENCH_IMPL_CNT; i++)
+        {
+            bench_pingPong( (BENCH_eImpl_t) i, bench_au32Size[s] );
+        }
+    }
+
+    exit( 0 );
+}
+
+/**
+ * Measure send and receive from one task without context switches
+ * The queue is filled up to aDepth messages and drained again until
+ * BENCH_MSG_CNT messages have been transferred.
+ * @param   aImpl       Implementation
+ * @param   aSize       Payload size in bytes
+ * @param   aDepth      Queue depth
+ */
+static void bench_throughput( BENCH_eImpl_t aImpl, uint32_t aSize, uint32_t aDepth )
+{
+    static uint8_t au8Tx[IPC_MAX_DATA_LENGTH];
+    static uint8_t au8Rx[IPC_MAX_DATA_LENGTH];
+    BENCH_sChannel_t sChannel;
+    uint64_t sendNs     = 0;
+    uint64_t recvNs     = 0;
+    uint32_t rounds     = BENCH_MSG_CNT / aDepth;
+
+    memset( au8Tx, 0xA5, sizeof( au8Tx ) );
+    bench_open( &sChannel, aImpl, aSize, aDepth, xTaskGetCurrentTaskHandle() );
+
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        uint64_t t0 = bench_now();
+        for (uint32_t i = 0; i < aDepth; i++)
+        {
+            bench_send( &sChannel, au8Tx );
+        }
+        uint64_t t1 = bench_now();
+        for (uint32_t i = 0; i < aDepth; i++)
+        {
+            bench_receive( &sChannel, au8Rx, 0 );
+        }
+        uint64_t t2 = bench_now();
+
+        sendNs += t1 - t0;
+        recvNs += t2 - t1;
+    }
+
+    (void) ulTaskNotifyTakeIndexed( BENCH_NOTIFY_INDEX, pdTRUE, 0 );  // Drop the notifications of IPC_send()
+    bench_close( &sChannel );
+
+    bench_print( "send", aImpl, aSize, aDepth, sendNs, rounds * aDepth );
+    bench_print( "receive", aImpl, aSize, aDepth, recvNs, rounds * aDepth );
+}
+
+/**
+ * Measure the round trip time between two tasks
+ * The echo task sends every message back, so each round trip has two sends,
+ * two receives and two context switches.
+ * @param   aImpl       Implementation
+ * @param   aSize       Payload size in bytes
+ */
+static void bench_pingPong( BENCH_eImpl_t aImpl, uint32_t aSize )
+{
+    static uint8_t au8Tx[IPC_MAX_DATA_LENGTH];
+    static uint8_t au8Rx[IPC_MAX_DATA_LENGTH];
+    static BENCH_sPingPong_t sPingPong;
+    TaskHandle_t echo;
+
+    /* The echo task has a lower priority, so it waits until the channels are open */
+    sPingPong.master = xTaskGetCurrentTaskHandle();
+    if (pdPASS != xTaskCreate( bench_echoTask, "echo", configMINIMAL_STACK_SIZE * 4, &sPingPong, BENCH_PRIO_ECHO, &echo ))
+    {
+        printf( "Task creation failed!\n" );
+        exit( 1 );
+    }
+    bench_open( &sPingPong.request, aImpl, aSize, 1, echo );
+    bench_open( &sPingPong.reply, aImpl, aSize, 1, sPingPong.master );
+
+    uint64_t t0 = bench_now();
+    for (uint32_t i = 0; i < BENCH_PINGPONG_CNT; i++)
+    {
+        bench_send( &sPingPong.request, au8Tx );
+        bench_receive( &sPingPong.reply, au8Rx, portMAX_DELAY );
+    }
+    uint64_t t1 = bench_now();
+
+    (void) ulTaskNotifyTake( pdTRUE, portMAX_DELAY ); // The echo task is done with the channels
+    bench_close( &sPingPong.request );
+    bench_close( &sPingPong.reply );
+
+    bench_print( "pingpong", aImpl, aSize, 1, t1 - t0, BENCH_PINGPONG_CNT );
+}
+
+/**
+ * Echo task of bench_pingPong()
+ */
+static void bench_echoTask( void * param )
+{
+    static uint8_t au8Buf[IPC_MAX_DATA_LENGTH];
+    BENCH_sPingPong_t * psPingPong = (BENCH_sPingPong_t *) param;
+
+    for (uint32_t i = 0; i < BENCH_PINGPONG_CNT; i++)
+    {
+        bench_receive( &psPingPong->request, au8Buf, portMAX_DELAY );
+        bench_send( &psPingPong->reply, au8Buf );
+    }
+
+    xTaskNotifyGive( psPingPong->master );
+    vTaskDelete( NULL );
+}
+
+/**
+ * Create the channel of a measurement
+ * @param   psChannel   Channel
+ * @param   aImpl       Implementation
+ * @param   aSize       Payload size in bytes
+ * @param   aDepth      Number of messages the channel can hold
+ * @param   aRecv       Receiver task
+ */
+static void bench_open( BENCH_sChannel_t * psChannel, BENCH_eImpl_t aImpl, uint32_t aSize, uint32_t aDepth, TaskHandle_t aRecv )
+{
+    psChannel->impl = aImpl;
+    psChannel->size = aSize;
+
+    switch (aImpl)
+    {
+        case E_BENCH_IPC:
+        case E_BENCH_IPC_ZC:
+            /* Each channel of a ping-pong has its own storage */
+            psChannel->ipcId = (IPC_eTaskID_t) bench_u32NextId++;
+            BENCH_CHECK( E_IPC_SUCCESS == IPC_createHandlerStatic( psChannel->ipcId, aRecv, aDepth, aSize,
+                                                                    bench_au8Storage[psChannel->ipcId & 1] ) );
+            BENCH_CHECK( E_IPC_SUCCESS == IPC_setNotifyIndex( psChannel->ipcId, BENCH_NOTIFY_INDEX ) );
+            break;
+        case E_BENCH_QUEUE:
+            psChannel->queue = xQueueCreate( aDepth, aSize );
+            BENCH_CHECK( psChannel->queue != NULL );
+            break;
+        default:
+            psChannel->msgBuf = xMessageBufferCreate( aDepth * (aSize + sizeof( size_t )) );
+            BENCH_CHECK( psChannel->msgBuf != NULL );
+            break;
+    }
+}
+
+/**
+ * Delete the channel of a measurement
+ * IPC handlers stay registered, their task ID is just not used again.
+ * @param   psChannel   Channel
+ */
+static void bench_close( BENCH_sChannel_t * psChannel )
+{
+    if (psChannel->impl == E_BENCH_QUEUE)
+    {
+        vQueueDelete( psChannel->queue );
+    }
+    else if (psChannel->impl == E_BENCH_MSGBUF)
+    {
+        vMessageBufferDelete( psChannel->msgBuf );
+    }
+}
+
+/**
+ * Send one message of the channel's payload size
+ * @param   psChannel   Channel
+ * @param   apData      Payload
+ */
+static void bench_send( BENCH_sChannel_t * psChannel, const uint8_t * apData )
+{
+    uint8_t * pu8Buf;
+
+    switch (psChannel->impl)
+    {
+        case E_BENCH_IPC:
+            BENCH_CHECK( E_IPC_SUCCESS == IPC_send( psChannel->ipcId, E_IPC_MSG_TYPE_1, (uint8_t *) apData, psChannel->size ) );
+            break;
+        case E_BENCH_IPC_ZC:
+            BENCH_CHECK( E_IPC_SUCCESS == IPC_sendReserve( psChannel->ipcId, E_IPC_MSG_TYPE_1, psChannel->size, &pu8Buf ) );
+            memcpy( pu8Buf, apData, psChannel->size );  // Stands in for a producer writing in place
+            BENCH_CHECK( E_IPC_SUCCESS == IPC_sendCommit( psChannel->ipcId ) );
+            break;
+        case E_BENCH_QUEUE:
+            BENCH_CHECK( pdPASS == xQueueSend( psChannel->queue, apData, 0 ) );
+            break;
+        default:
+            BENCH_CHECK( psChannel->size == xMessageBufferSend( psChannel->msgBuf, apData, psChannel->size, 0 ) );
+            break;
+    }
+}
+
+/**
+ * Receive one message of the channel
+ * @param   psChannel       Channel
+ * @param   apData          Buffer for the payload
+ * @param   xTicksToWait    Max. time to wait for the message
+ */
+static void bench_receive( BENCH_sChannel_t * psChannel, uint8_t * apData, TickType_t xTicksToWait )
+{
+    const IPC_sMsg_t * psMsg;
+    IPC_eError_t error;
+
+    switch (psChannel->impl)
+    {
+        case E_BENCH_IPC:
+            error = IPC_receiveWait( psChannel->ipcId, &bench_sMsgBuff, xTicksToWait );
+            BENCH_CHECK( E_IPC_SUCCESS == error || E_IPC_RECV_MORE == error );
+            break;
+        case E_BENCH_IPC_ZC:
+            while (E_IPC_ERR_RECV_FAIL == IPC_receivePeek( psChannel->ipcId, &psMsg ))
+            {
+                BENCH_CHECK( xTicksToWait != 0 );
+                (void) ulTaskNotifyTakeIndexed( BENCH_NOTIFY_INDEX, pdTRUE, xTicksToWait );
+            }
+            (void) IPC_receiveRelease( psChannel->ipcId );  // The payload is used in place
+            break;
+        case E_BENCH_QUEUE:
+            BENCH_CHECK( pdPASS == xQueueReceive( psChannel->queue, apData, xTicksToWait ) );
+            break;
+        default:
+            BENCH_CHECK( psChannel->size == xMessageBufferReceive( psChannel->msgBuf, apData, psChannel->size, xTicksToWait ) );
+            break;
+    }
+}
+
+/**
+ * Get the host time
+ * @return  time in ns
+ */
+static uint64_t bench_now( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Print one result line
+ * @param   pcTest      Name of the measurement
+ * @param   aImpl       Implementation
+ * @param   aSize       Payload size in bytes
+ * @param   aDepth      Queue depth
+ * @param   aNs         Total time in ns
+ * @param   aCount      Number of messages or round trips
+ */
+static void bench_print( const char * pcTest, BENCH_eImpl_t aImpl, uint32_t aSize, uint32_t aDepth, uint64_t aNs, uint32_t aCount )
+{
+    double nsPerMsg = (double) aNs / aCount;
+    printf( "%-9s %-7s %5u %5u %10.1f %12.0f\n", pcTest, bench_apcImpl[aImpl], (unsigned) aSize, (unsigned) aDepth,
+            nsPerMsg, 1e9 / nsPerMsg );
+}
+
+/*!
+ * @brief Assert hook of FreeRTOSConfig.h
+ */
+void vAssertCalled( const char * pcFile, unsigned long ulLine )
+{
+    printf( "ASSERT %s:%lu\n", pcFile, ulLine );
+    exit( 1 );
+}
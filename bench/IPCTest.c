@@ -0,0 +1,337 @@
+/*
+ * This IPCTest.c checks the storage backends of the IPCHandler on the host,
+ * using the FreeRTOS POSIX port. It is built like IPCBench.c, see README.md.
+ *
+ * The checks run in one task, which sends to its own handlers and receives
+ * the messages again:
+ *  - slot:     a slot queue keeps the order, rejects a full queue and
+ *              survives many laps of its indices
+ *  - ring:     records of varying length wrap around the end of a byte ring
+ *  - mailbox:  the triple buffer swaps in the latest message, also while the
+ *              receiver has a message borrowed
+ *  - pool:     the blocks of a pool class leave and rejoin the free list
+ *
+ * The process ends with exit code 0 if all checks pass and prints the failed
+ * check and exits with 1 otherwise.
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "IPCHandler.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TEST_ID_SLOT            20      /*!< Handler of the slot queue check */
+#define TEST_ID_RING            21      /*!< Handler of the byte ring check */
+#define TEST_ID_MAILBOX         22      /*!< Handler of the mailbox check */
+#define TEST_ID_POOL            23      /*!< Handler of the pool check */
+#define TEST_SLOT_DEPTH         4       /*!< Messages the slot queue holds */
+#define TEST_SLOT_LEN           16      /*!< Payload of a slot */
+#define TEST_RING_LEN_MAX       24      /*!< Largest payload sent to the ring */
+#define TEST_RING_RECORDS       6       /*!< Records of TEST_RING_LEN_MAX the ring has room for */
+#define TEST_RING_SIZE          (TEST_RING_RECORDS * IPC_RING_RECORD_SIZE( TEST_RING_LEN_MAX ))
+#define TEST_RING_LEN( seq )    (((seq) < TEST_RING_RECORDS) ? TEST_RING_LEN_MAX : 1 + ((seq) * 7) % TEST_RING_LEN_MAX)
+#define TEST_POOL_LEN           64      /*!< Payload of a pool block, larger than a slot of TEST_ID_POOL */
+#define TEST_POOL_BLOCKS        3       /*!< Blocks of the pool class */
+#define TEST_ROUNDS             1000    /*!< Repetitions of the wrapping checks */
+#define TEST_PRIO               ( tskIDLE_PRIORITY + 1 )
+
+#define TEST_CHECK( x )         do { if (!(x)) vAssertCalled( __FILE__, __LINE__ ); } while (0)  /*!< Also evaluated if configASSERT() is disabled */
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+void vAssertCalled( const char * pcFile, unsigned long ulLine );
+
+static void test_task( void * param );
+static void test_slotQueue( TaskHandle_t );
+static void test_ringWrap( TaskHandle_t );
+static void test_mailboxSwap( TaskHandle_t );
+static void test_poolFreeList( TaskHandle_t );
+static void test_fill( uint8_t *, uint32_t, uint32_t );
+static void test_verify( const IPC_sMsg_t *, uint32_t, uint32_t );
+static uint32_t test_received( IPC_eError_t );
+
+/*******************************************************************************
+ * Globals
+ ******************************************************************************/
+static uint8_t test_au8Slot[IPC_QUEUE_STORAGE_SIZE( TEST_SLOT_DEPTH, TEST_SLOT_LEN )] IPC_STORAGE_ATTR;
+static uint8_t test_au8Ring[TEST_RING_SIZE] IPC_STORAGE_ATTR;
+static uint8_t test_au8Mailbox[IPC_MAILBOX_STORAGE_SIZE( TEST_SLOT_LEN )] IPC_STORAGE_ATTR;
+static uint8_t test_au8PoolSlot[IPC_QUEUE_STORAGE_SIZE( TEST_POOL_BLOCKS + 1, TEST_SLOT_LEN )] IPC_STORAGE_ATTR;
+static uint8_t test_au8Pool[IPC_QUEUE_STORAGE_SIZE( TEST_POOL_BLOCKS, TEST_POOL_LEN )] IPC_STORAGE_ATTR;
+
+static IPC_sMsg_t test_sMsgBuff;    /*!< Receive buffer of IPC_receive() */
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/*!
+ * @brief Main function
+ */
+int main( void )
+{
+    IPC_initIPCHandler();
+
+    if (pdPASS != xTaskCreate( test_task, "test", configMINIMAL_STACK_SIZE * 4, NULL, TEST_PRIO, NULL ))
+    {
+        printf( "Task creation failed!\n" );
+        return 1;
+    }
+
+    vTaskStartScheduler();
+    return 0;
+}
+
+/**
+ * Run all checks and end the process
+ * The pool check runs last, as its class is used by every handler whose slots
+ * are too small for a payload.
+ */
+static void test_task( void * param )
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    (void) param;
+
+    test_slotQueue( self );
+    printf( "PASS slot\n" );
+    test_ringWrap( self );
+    printf( "PASS ring\n" );
+    test_mailboxSwap( self );
+    printf( "PASS mailbox\n" );
+    test_poolFreeList( self );
+    printf( "PASS pool\n" );
+
+    exit( 0 );
+}
+
+/**
+ * Fill the queue, drain it in order, and repeat until the indices have gone
+ * around many times
+ * @param   aSelf   Receiver task
+ */
+static void test_slotQueue( TaskHandle_t aSelf )
+{
+    uint8_t au8Tx[TEST_SLOT_LEN];
+    uint32_t seq = 0;
+
+    TEST_CHECK( E_IPC_SUCCESS == IPC_createHandlerStatic( TEST_ID_SLOT, aSelf, TEST_SLOT_DEPTH, TEST_SLOT_LEN, test_au8Slot ) );
+    TEST_CHECK( E_IPC_ERR_RECV_FAIL == IPC_receive( TEST_ID_SLOT, &test_sMsgBuff ) );
+    TEST_CHECK( E_IPC_ERR_SEND_FAIL == IPC_send( TEST_ID_SLOT, E_IPC_MSG_TYPE_1, au8Tx, TEST_SLOT_LEN + 1 ) );
+
+    for (uint32_t r = 0; r < TEST_ROUNDS; r++)
+    {
+        /* A different fill level every round, so head and tail meet at every index */
+        uint32_t cnt = 1 + r % TEST_SLOT_DEPTH;
+        for (uint32_t i = 0; i < cnt; i++)
+        {
+            uint32_t len = 1 + (seq + i) % TEST_SLOT_LEN;
+            test_fill( au8Tx, len, seq + i );
+            TEST_CHECK( E_IPC_SUCCESS == IPC_send( TEST_ID_SLOT, E_IPC_MSG_TYPE_1, au8Tx, (int) len ) );
+        }
+        if (cnt == TEST_SLOT_DEPTH)
+        {
+            TEST_CHECK( E_IPC_ERR_QUEUE_FULL == IPC_send( TEST_ID_SLOT, E_IPC_MSG_TYPE_1, au8Tx, 1 ) );
+        }
+        for (uint32_t i = 0; i < cnt; i++)
+        {
+            IPC_eError_t error = IPC_receive( TEST_ID_SLOT, &test_sMsgBuff );
+            TEST_CHECK( error == ((i + 1 < cnt) ? E_IPC_RECV_MORE : E_IPC_SUCCESS) );
+            test_verify( &test_sMsgBuff, 1 + seq % TEST_SLOT_LEN, seq );
+            seq++;
+        }
+        TEST_CHECK( E_IPC_ERR_RECV_FAIL == IPC_receive( TEST_ID_SLOT, &test_sMsgBuff ) );
+    }
+}
+
+/**
+ * Send records of varying length into a byte ring until it is full, then take
+ * one out at a time, so the records start at every offset and wrap around its
+ * end. The first records are the largest, so the last of them would end at the
+ * buffer end while the head is still at offset 0, which the ring must refuse.
+ * @param   aSelf   Receiver task
+ */
+static void test_ringWrap( TaskHandle_t aSelf )
+{
+    uint8_t au8Tx[TEST_RING_LEN_MAX];
+    uint32_t sent = 0;
+    uint32_t recv = 0;
+
+    TEST_CHECK( E_IPC_SUCCESS == IPC_createRingHandler( TEST_ID_RING, aSelf, test_au8Ring, sizeof( test_au8Ring ) ) );
+    TEST_CHECK( E_IPC_ERR_RECV_FAIL == IPC_receive( TEST_ID_RING, &test_sMsgBuff ) );
+
+    while (recv < TEST_ROUNDS)
+    {
+        uint32_t len = TEST_RING_LEN( sent );
+        test_fill( au8Tx, len, sent );
+        IPC_eError_t error = IPC_send( TEST_ID_RING, E_IPC_MSG_TYPE_2, au8Tx, (int) len );
+        if (error == E_IPC_SUCCESS)
+        {
+            sent++;
+            continue;
+        }
+        TEST_CHECK( error == E_IPC_ERR_QUEUE_FULL );
+        TEST_CHECK( sent > recv );  // Only a ring with records in it can be full
+
+        error = IPC_receive( TEST_ID_RING, &test_sMsgBuff );
+        TEST_CHECK( test_received( error ) );
+        TEST_CHECK( test_sMsgBuff.eIPC_MsgType == E_IPC_MSG_TYPE_2 );
+        test_verify( &test_sMsgBuff, TEST_RING_LEN( recv ), recv );
+        recv++;
+    }
+
+    while (recv < sent)
+    {
+        TEST_CHECK( test_received( IPC_receive( TEST_ID_RING, &test_sMsgBuff ) ) );
+        test_verify( &test_sMsgBuff, TEST_RING_LEN( recv ), recv );
+        recv++;
+    }
+    TEST_CHECK( E_IPC_ERR_RECV_FAIL == IPC_receive( TEST_ID_RING, &test_sMsgBuff ) );
+}
+
+/**
+ * Replace unreceived messages of a mailbox, also while the receiver holds a
+ * message with IPC_receivePeek()
+ * @param   aSelf   Receiver task
+ */
+static void test_mailboxSwap( TaskHandle_t aSelf )
+{
+    uint8_t au8Tx[TEST_SLOT_LEN];
+    const IPC_sMsg_t * psMsg;
+
+    TEST_CHECK( E_IPC_SUCCESS == IPC_createMailboxHandler( TEST_ID_MAILBOX, aSelf, TEST_SLOT_LEN, test_au8Mailbox ) );
+    TEST_CHECK( E_IPC_ERR_RECV_FAIL == IPC_receive( TEST_ID_MAILBOX, &test_sMsgBuff ) );
+
+    for (uint32_t r = 0; r < TEST_ROUNDS; r++)
+    {
+        uint32_t seq = 3 * r;
+
+        /* Only the last of several messages is received */
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            test_fill( au8Tx, TEST_SLOT_LEN, seq + i );
+            TEST_CHECK( E_IPC_SUCCESS == IPC_send( TEST_ID_MAILBOX, E_IPC_MSG_TYPE_1, au8Tx, TEST_SLOT_LEN ) );
+        }
+        TEST_CHECK( test_received( IPC_receive( TEST_ID_MAILBOX, &test_sMsgBuff ) ) );
+        test_verify( &test_sMsgBuff, TEST_SLOT_LEN, seq + 2 );
+        TEST_CHECK( E_IPC_ERR_RECV_FAIL == IPC_receive( TEST_ID_MAILBOX, &test_sMsgBuff ) );
+
+        /* A borrowed message stays intact while newer ones are sent */
+        TEST_CHECK( E_IPC_SUCCESS == IPC_send( TEST_ID_MAILBOX, E_IPC_MSG_TYPE_1, au8Tx, TEST_SLOT_LEN ) );
+        TEST_CHECK( test_received( IPC_receivePeek( TEST_ID_MAILBOX, &psMsg ) ) );
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            uint8_t au8New[TEST_SLOT_LEN];
+            test_fill( au8New, TEST_SLOT_LEN, seq + 3 + i );
+            TEST_CHECK( E_IPC_SUCCESS == IPC_send( TEST_ID_MAILBOX, E_IPC_MSG_TYPE_1, au8New, TEST_SLOT_LEN ) );
+        }
+        test_verify( psMsg, TEST_SLOT_LEN, seq + 2 );
+        (void) IPC_receiveRelease( TEST_ID_MAILBOX );
+
+        TEST_CHECK( test_received( IPC_receive( TEST_ID_MAILBOX, &test_sMsgBuff ) ) );
+        test_verify( &test_sMsgBuff, TEST_SLOT_LEN, seq + 4 );
+        TEST_CHECK( E_IPC_ERR_RECV_FAIL == IPC_receive( TEST_ID_MAILBOX, &test_sMsgBuff ) );
+    }
+}
+
+/**
+ * Take all blocks of a pool class, check that the next send fails, and give
+ * them back. The free list hands them out in reverse order the next round.
+ * @param   aSelf   Receiver task
+ */
+static void test_poolFreeList( TaskHandle_t aSelf )
+{
+    uint8_t au8Tx[TEST_POOL_LEN];
+    uint32_t seq = 0;
+
+    TEST_CHECK( E_IPC_SUCCESS == IPC_createHandlerStatic( TEST_ID_POOL, aSelf, TEST_POOL_BLOCKS + 1, TEST_SLOT_LEN,
+                                                           test_au8PoolSlot ) );
+    TEST_CHECK( E_IPC_ERR_SEND_FAIL == IPC_send( TEST_ID_POOL, E_IPC_MSG_TYPE_1, au8Tx, TEST_POOL_LEN ) );  // No pool yet
+    TEST_CHECK( E_IPC_SUCCESS == IPC_addPoolClass( TEST_POOL_LEN, TEST_POOL_BLOCKS, test_au8Pool ) );
+
+    for (uint32_t r = 0; r < TEST_ROUNDS; r++)
+    {
+        /* The queue has a free slot left, so only the exhausted pool can refuse the last send */
+        for (uint32_t i = 0; i < TEST_POOL_BLOCKS; i++)
+        {
+            test_fill( au8Tx, TEST_POOL_LEN, seq + i );
+            TEST_CHECK( E_IPC_SUCCESS == IPC_send( TEST_ID_POOL, E_IPC_MSG_TYPE_1, au8Tx, TEST_POOL_LEN ) );
+        }
+        TEST_CHECK( E_IPC_ERR_QUEUE_FULL == IPC_send( TEST_ID_POOL, E_IPC_MSG_TYPE_1, au8Tx, TEST_POOL_LEN ) );
+
+        /* A payload that fits into the slot doesn't need a block */
+        test_fill( au8Tx, TEST_SLOT_LEN, seq + TEST_POOL_BLOCKS );
+        TEST_CHECK( E_IPC_SUCCESS == IPC_send( TEST_ID_POOL, E_IPC_MSG_TYPE_1, au8Tx, TEST_SLOT_LEN ) );
+
+        /* Receiving puts every block back on the free list */
+        TEST_CHECK( test_received( IPC_receive( TEST_ID_POOL, &test_sMsgBuff ) ) );
+        test_verify( &test_sMsgBuff, TEST_POOL_LEN, seq );
+        for (uint32_t i = 1; i < TEST_POOL_BLOCKS; i++)
+        {
+            TEST_CHECK( test_received( IPC_receive( TEST_ID_POOL, &test_sMsgBuff ) ) );
+            test_verify( &test_sMsgBuff, TEST_POOL_LEN, seq + i );
+        }
+        TEST_CHECK( E_IPC_SUCCESS == IPC_receive( TEST_ID_POOL, &test_sMsgBuff ) );
+        test_verify( &test_sMsgBuff, TEST_SLOT_LEN, seq + TEST_POOL_BLOCKS );
+        TEST_CHECK( E_IPC_ERR_RECV_FAIL == IPC_receive( TEST_ID_POOL, &test_sMsgBuff ) );
+
+        seq += TEST_POOL_BLOCKS + 1;
+    }
+}
+
+/**
+ * Write the test pattern of a message
+ * @param   apData      Payload
+ * @param   aLen        Payload size in bytes
+ * @param   aSeq        Sequence number of the message
+ */
+static void test_fill( uint8_t * apData, uint32_t aLen, uint32_t aSeq )
+{
+    for (uint32_t i = 0; i < aLen; i++)
+    {
+        apData[i] = (uint8_t) (aSeq * 31 + i);
+    }
+}
+
+/**
+ * Check a received message against the test pattern
+ * @param   psMsg       Received message
+ * @param   aLen        Expected payload size in bytes
+ * @param   aSeq        Expected sequence number
+ */
+static void test_verify( const IPC_sMsg_t * psMsg, uint32_t aLen, uint32_t aSeq )
+{
+    TEST_CHECK( psMsg->u32DataLen == aLen );
+    for (uint32_t i = 0; i < aLen; i++)
+    {
+        TEST_CHECK( psMsg->u8Data[i] == (uint8_t) (aSeq * 31 + i) );
+    }
+}
+
+/**
+ * Check that a receive call returned a message
+ * @param   aError      Result of the call
+ * @return  1 if a message was received, else 0
+ */
+static uint32_t test_received( IPC_eError_t aError )
+{
+    return (aError == E_IPC_SUCCESS || aError == E_IPC_RECV_MORE);
+}
+
+/*!
+ * @brief Assert hook of FreeRTOSConfig.h
+ */
+void vAssertCalled( const char * pcFile, unsigned long ulLine )
+{
+    printf( "ASSERT %s:%lu\n", pcFile, ulLine );
+    exit( 1 );
+}
@@ -107,21 +107,36 @@ void demo_task1( void *param )
 //                    PRINT_TO_TERMINAL((char *) msgBuff.u8Data);
 //                }
 //             } while (E_IPC_RECV_MORE == error);
+//        }
+
+    /* variant 3 using callbacks registered with IPC_registerCallback() */
+//        if (0 != ulTaskNotifyTake( pdTRUE, 2 ))
+//        {
+//            while (E_IPC_RECV_MORE == IPC_dispatch( E_IPC_TASK_ID_1, IPC_BATCH_MAX ))
+//                ;
 //        }
     
-      /* variant 2 using task notification value */
-      uint32_t eventsToProcess = ulTaskNotifyTake( pdFALSE, 1 );
-      if (eventsToProcess != 0)
+      /* variant 2 using task notification value, drained further since a batch notifies only once */
+//      uint32_t eventsToProcess = ulTaskNotifyTake( pdTRUE, 1 );
+//      if (eventsToProcess != 0)
+//      {
+//        int error = 0;
+//        while (eventsToProcess > 0 || E_IPC_RECV_MORE == error)
+//        {
+//          error = IPC_receive( E_IPC_TASK_ID_1, &msgBuff );
+//          if (E_IPC_SUCCESS == error || E_IPC_RECV_MORE == error)
+//          {
+//            PRINTF( msgBuff.u8Data );
+//          }
+//          eventsToProcess = (eventsToProcess > 0) ? eventsToProcess - 1 : 0;
+//        }
+//      }
+
+      /* variant 4 blocking in IPC_receiveWait() until a message arrives */
+      int error = IPC_receiveWait( E_IPC_TASK_ID_1, &msgBuff, portMAX_DELAY );
+      if (E_IPC_SUCCESS == error || E_IPC_RECV_MORE == error)
       {
-        while (eventsToProcess > 0)
-        {
-          int error = IPC_receive( E_IPC_TASK_ID_1, &msgBuff );
-          if (E_IPC_SUCCESS == error || E_IPC_RECV_MORE == error)
-          {
-            PRINTF( msgBuff.u8Data );
-          }
-          eventsToProcess--;
-        }
+        PRINTF( msgBuff.u8Data );
       }
   }
 }